@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/bench_figure.dir/bench/bench_figure.cpp.o"
+  "CMakeFiles/bench_figure.dir/bench/bench_figure.cpp.o.d"
+  "bench_figure"
+  "bench_figure.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/bench_figure.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/figure.dir/src/main.cpp.o"
+  "CMakeFiles/figure.dir/src/main.cpp.o.d"
+  "figure"
+  "figure.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/figure.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,12 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/test_figure.dir/test/test_figure.cpp.o"
+  "CMakeFiles/test_figure.dir/test/test_figure.cpp.o.d"
+  "test_figure"
+  "test_figure.pdb"
+  "test_figure[1]_tests.cmake"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/test_figure.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,5 @@
+if(EXISTS "/root/repo/_rel/test_figure[1]_tests.cmake")
+  include("/root/repo/_rel/test_figure[1]_tests.cmake")
+else()
+  add_test(test_figure_NOT_BUILT test_figure_NOT_BUILT)
+endif()
@@ -0,0 +1,55 @@
+#include <benchmark/benchmark.h>
+#include <memory>
+#include "../src/arena.h"
+#include "../src/array.h"
+#include "../src/figures.h"
+
+// Сравнение построения и удаления сцены: обычный make_shared против арены.
+// Аргументы: число фигур и число точек в фигуре (больше 5 - точки уходят
+// из встроенного буфера в кучу или арену)
+
+template<class F>
+static void fill(F& figure, int vertices) {
+    for (int v = 0; v < vertices; ++v) figure.add_point(Point<int>(v, v * 2));
+}
+
+static void BM_SceneHeap(benchmark::State& state) {
+    const int figures = static_cast<int>(state.range(0));
+    const int vertices = static_cast<int>(state.range(1));
+    for (auto _ : state) {
+        Array<std::shared_ptr<Figure<int>>> scene;
+        scene.reserve(figures);
+        for (int i = 0; i < figures; ++i) {
+            auto pentagon = std::make_shared<Pentagon<int>>(std::pmr::new_delete_resource());
+            fill(*pentagon, vertices);
+            scene.push_back(std::move(pentagon));
+        }
+        benchmark::DoNotOptimize(scene);
+    }
+    state.SetItemsProcessed(state.iterations() * figures);
+}
+
+static void BM_SceneArena(benchmark::State& state) {
+    const int figures = static_cast<int>(state.range(0));
+    const int vertices = static_cast<int>(state.range(1));
+    Arena arena(1 << 20);
+    for (auto _ : state) {
+        {
+            Array<std::shared_ptr<Figure<int>>> scene;
+            scene.reserve(figures);
+            for (int i = 0; i < figures; ++i) {
+                auto pentagon = make_shared_in<Pentagon<int>>(arena);
+                fill(*pentagon, vertices);
+                scene.push_back(std::move(pentagon));
+            }
+            benchmark::DoNotOptimize(scene);
+        }
+        arena.release();
+    }
+    state.SetItemsProcessed(state.iterations() * figures);
+}
+
+BENCHMARK(BM_SceneHeap)->ArgsProduct({{1 << 10, 1 << 16}, {5, 64}});
+BENCHMARK(BM_SceneArena)->ArgsProduct({{1 << 10, 1 << 16}, {5, 64}});
+
+BENCHMARK_MAIN();
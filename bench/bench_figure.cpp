@@ -0,0 +1,285 @@
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+#include "../src/array.h"
+#include "../src/figures.h"
+#include "../src/parallel.h"
+#include "../src/simd_area.h"
+#include "../src/spatial_index.h"
+#include "../src/text_parser.h"
+
+// Микробенчмарки ядра: контейнеры, построение и копирование фигур,
+// площадь, центр и подсчёт по сцене как в main.cpp, а также пакетные
+// площади, параллельная сумма, текстовый разбор и пространственные запросы.
+// Параметры: число вершин или размер сцены, тип координат T.
+// Результаты в JSON: ./bench_figure --benchmark_out=bench.json --benchmark_out_format=json
+
+template<template<class> class F, class T>
+static F<T> make_figure(int vertices) {
+    F<T> figure;
+    for (int v = 0; v < vertices; ++v) {
+        // Точки на сторонах квадрата, чтобы площадь была ненулевой
+        const int side = v % 4;
+        const int t = v / 4;
+        const int x = side == 0 ? t : side == 2 ? -t : (side == 1 ? vertices : -vertices);
+        const int y = side == 1 ? t : side == 3 ? -t : (side == 0 ? -vertices : vertices);
+        figure.add_point(Point<T>(T(x), T(y)));
+    }
+    return figure;
+}
+
+template<class T>
+static void BM_PointContainerPushBack(benchmark::State& state) {
+    const size_t n = static_cast<size_t>(state.range(0));
+    for (auto _ : state) {
+        PointContainer<Point<T>> points;
+        for (size_t i = 0; i < n; ++i) points.push_back(Point<T>(T(i), T(i)));
+        benchmark::DoNotOptimize(points.data());
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+template<class T>
+static void BM_PointContainerIndex(benchmark::State& state) {
+    const size_t n = static_cast<size_t>(state.range(0));
+    PointContainer<Point<T>> points;
+    for (size_t i = 0; i < n; ++i) points.push_back(Point<T>(T(i), T(i)));
+    for (auto _ : state) {
+        T sum = 0;
+        for (size_t i = 0; i < n; ++i) sum += points[i].getX();
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+template<class T>
+static void BM_ArrayPushBack(benchmark::State& state) {
+    const size_t n = static_cast<size_t>(state.range(0));
+    for (auto _ : state) {
+        Array<T> arr;
+        for (size_t i = 0; i < n; ++i) arr.push_back(T(i));
+        benchmark::DoNotOptimize(arr.data());
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+template<class T>
+static void BM_ArrayReserve(benchmark::State& state) {
+    const size_t n = static_cast<size_t>(state.range(0));
+    for (auto _ : state) {
+        Array<T> arr;
+        arr.reserve(n);
+        for (size_t i = 0; i < n; ++i) arr.push_back(T(i));
+        benchmark::DoNotOptimize(arr.data());
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+template<class T>
+static void BM_FigureConstruct(benchmark::State& state) {
+    const int n = static_cast<int>(state.range(0));
+    for (auto _ : state) {
+        auto figure = make_figure<Pentagon, T>(n);
+        benchmark::DoNotOptimize(figure);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+template<class T>
+static void BM_FigureCopy(benchmark::State& state) {
+    const auto figure = make_figure<Pentagon, T>(static_cast<int>(state.range(0)));
+    for (auto _ : state) {
+        Pentagon<T> copy(figure);
+        benchmark::DoNotOptimize(copy);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Площадь и центр берутся из кэша за O(1), поэтому единица - запрос, а не
+// вершина
+template<class T>
+static void BM_FigureArea(benchmark::State& state) {
+    auto figure = make_figure<Pentagon, T>(static_cast<int>(state.range(0)));
+    Figure<T>& base = figure;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(static_cast<double>(base));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Площадь заново по всем вершинам, без кэша
+template<class T>
+static void BM_FigureAreaUncached(benchmark::State& state) {
+    const auto figure = make_figure<Pentagon, T>(static_cast<int>(state.range(0)));
+    const Figure<T>& base = figure;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(base.template area<FastArithmetic>());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+template<class T>
+static void BM_FigureCenter(benchmark::State& state) {
+    auto figure = make_figure<Pentagon, T>(static_cast<int>(state.range(0)));
+    const Figure<T>& base = figure;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(base.center());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// Подсчёт как в main.cpp: площадь и центр каждой фигуры сцены
+template<class T>
+static void BM_SceneAggregate(benchmark::State& state) {
+    const size_t n = static_cast<size_t>(state.range(0));
+    Array<std::shared_ptr<Figure<T>>> figures;
+    figures.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        switch (i % 3) {
+        case 0: figures.push_back(std::make_shared<Rhombus<T>>(make_figure<Rhombus, T>(4))); break;
+        case 1: figures.push_back(std::make_shared<Trapezoid<T>>(make_figure<Trapezoid, T>(4))); break;
+        default: figures.push_back(std::make_shared<Pentagon<T>>(make_figure<Pentagon, T>(5))); break;
+        }
+    }
+    for (auto _ : state) {
+        double total_area = 0;
+        for (size_t i = 0; i < figures.size(); ++i) {
+            total_area += static_cast<double>(*figures[i]);
+            benchmark::DoNotOptimize(figures[i]->center());
+        }
+        benchmark::DoNotOptimize(total_area);
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+// Пакетные площади FigureStore на заданном уровне SimdLevel. 8192 ромба
+// помещаются в кэш, так что меряется само ядро
+template<class T>
+static void BM_Areas(benchmark::State& state) {
+    const auto level = static_cast<SimdLevel>(state.range(0));
+    if (level > detect_simd_level()) {
+        state.SkipWithError("SIMD level is not supported");
+        return;
+    }
+    const size_t n = static_cast<size_t>(state.range(1));
+    FigureStore<T> store;
+    store.reserve(n, n * 4);
+    for (size_t i = 0; i < n; ++i) {
+        const T d = T(i % 100);
+        const Point<T> points[] = {{d, T(0)}, {T(2), T(2)}, {T(4), d}, {T(2), T(-2)}};
+        store.push_back(FigureKind::Rhombus, points);
+    }
+    std::vector<double> out(n);
+    for (auto _ : state) {
+        areas(store, std::span<double>(out), level);
+        benchmark::DoNotOptimize(out.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+// Сцена из n ромбов с диагоналями 2, разбросанных по квадрату side x side
+template<class T>
+static Array<std::shared_ptr<Figure<T>>> make_scene(size_t n, int side) {
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<int> pos(0, side);
+    Array<std::shared_ptr<Figure<T>>> figures;
+    figures.reserve(n);
+    for (size_t i = 0; i < n; ++i) {
+        const int x = pos(rng), y = pos(rng);
+        auto rhombus = std::make_shared<Rhombus<T>>();
+        rhombus->add_point(Point<T>(T(x - 1), T(y)));
+        rhombus->add_point(Point<T>(T(x), T(y + 1)));
+        rhombus->add_point(Point<T>(T(x + 1), T(y)));
+        rhombus->add_point(Point<T>(T(x), T(y - 1)));
+        figures.push_back(std::move(rhombus));
+    }
+    return figures;
+}
+
+// Общая площадь сцены пулом потоков по числу ядер
+template<class T>
+static void BM_ParallelTotalArea(benchmark::State& state) {
+    const size_t n = static_cast<size_t>(state.range(0));
+    const auto figures = make_scene<T>(n, 1000);
+    ThreadPool pool;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(parallel_total_area(figures, pool));
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+// Текстовый разбор: range(0) строк, range(1) потоков (0 - по числу ядер)
+template<class T>
+static void BM_ParseFigures(benchmark::State& state) {
+    const size_t n = static_cast<size_t>(state.range(0));
+    std::string text;
+    for (size_t i = 0; i < n; ++i) {
+        const int v = static_cast<int>(i % 1000);
+        text += "P 0 0 " + std::to_string(v) + " 0 3 1 2 " + std::to_string(v) + " 0 2\n";
+    }
+    for (auto _ : state) {
+        FigureStore<T> store;
+        parse_figures<T>(text, store, static_cast<size_t>(state.range(1)));
+        benchmark::DoNotOptimize(store.xs().data());
+    }
+    state.SetItemsProcessed(state.iterations() * n);
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(text.size()));
+}
+
+// Запросы окном 20 x 20 к индексу по range(0) фигурам; единица - запрос
+template<class T, class Index>
+static void spatial_query(benchmark::State& state, const Index& index) {
+    std::mt19937 rng(2);
+    std::uniform_int_distribution<int> pos(0, 1000);
+    std::vector<Bounds<T>> windows(1024);
+    for (auto& w : windows) {
+        const int x = pos(rng), y = pos(rng);
+        w = Bounds<T>{T(x), T(y), T(x + 20), T(y + 20)};
+    }
+    size_t i = 0, found = 0;
+    for (auto _ : state) {
+        const auto ids = index.query(windows[i++ & 1023]);
+        found += ids.size();
+        benchmark::DoNotOptimize(ids.data());
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["found"] = benchmark::Counter(static_cast<double>(found), benchmark::Counter::kAvgIterations);
+}
+
+template<class T>
+static void BM_RTreeQuery(benchmark::State& state) {
+    const auto figures = make_scene<T>(static_cast<size_t>(state.range(0)), 1000);
+    spatial_query<T>(state, RTree<T>(figures));
+}
+
+template<class T>
+static void BM_GridQuery(benchmark::State& state) {
+    const auto figures = make_scene<T>(static_cast<size_t>(state.range(0)), 1000);
+    spatial_query<T>(state, UniformGrid<T>(figures, 8.0));
+}
+
+#define FIGURE_BENCH(name, ...)                                  \
+    BENCHMARK_TEMPLATE(name, int)->__VA_ARGS__;                  \
+    BENCHMARK_TEMPLATE(name, double)->__VA_ARGS__
+
+FIGURE_BENCH(BM_PointContainerPushBack, RangeMultiplier(4)->Range(4, 4096));
+FIGURE_BENCH(BM_PointContainerIndex, RangeMultiplier(4)->Range(4, 4096));
+FIGURE_BENCH(BM_ArrayPushBack, RangeMultiplier(16)->Range(16, 1 << 20));
+FIGURE_BENCH(BM_ArrayReserve, RangeMultiplier(16)->Range(16, 1 << 20));
+FIGURE_BENCH(BM_FigureConstruct, RangeMultiplier(4)->Range(4, 1024));
+FIGURE_BENCH(BM_FigureCopy, RangeMultiplier(4)->Range(4, 1024));
+FIGURE_BENCH(BM_FigureArea, RangeMultiplier(4)->Range(4, 1024));
+FIGURE_BENCH(BM_FigureAreaUncached, RangeMultiplier(4)->Range(4, 1024));
+FIGURE_BENCH(BM_FigureCenter, RangeMultiplier(4)->Range(4, 1024));
+FIGURE_BENCH(BM_SceneAggregate, RangeMultiplier(16)->Range(16, 1 << 20));
+FIGURE_BENCH(BM_Areas, ArgNames({"simd", "figures"})->ArgsProduct({{0, 1, 2}, {8192}}));
+FIGURE_BENCH(BM_ParallelTotalArea, RangeMultiplier(16)->Range(1 << 12, 1 << 20)->UseRealTime());
+FIGURE_BENCH(BM_ParseFigures, ArgNames({"lines", "threads"})->ArgsProduct({{1 << 16, 1 << 20}, {1, 0}})->UseRealTime());
+FIGURE_BENCH(BM_RTreeQuery, RangeMultiplier(16)->Range(1 << 12, 1 << 20));
+FIGURE_BENCH(BM_GridQuery, RangeMultiplier(16)->Range(1 << 12, 1 << 20));
+
+BENCHMARK_MAIN();
@@ -0,0 +1,94 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+
+// Монотонная арена: память выдаётся подряд из больших блоков, освобождение
+// отдельного куска ничего не делает, а release() разом отдаёт все блоки.
+// Целую сцену можно построить в одной арене: фигуры, их точки и блоки
+// счётчиков shared_ptr, и потом освободить за число блоков, а не фигур.
+// Арена не потокобезопасна
+class Arena : public std::pmr::memory_resource {
+public:
+    explicit Arena(size_t block_size = 64 * 1024,
+                   std::pmr::memory_resource* upstream = std::pmr::new_delete_resource())
+        : _block_size(std::max<size_t>(block_size, 256)), _upstream(upstream) {}
+
+    ~Arena() override { release(); }
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // Освобождает все блоки. Объекты в арене должны быть уже не нужны
+    void release() noexcept {
+        while (_head) {
+            Block* next = _head->next;
+            _upstream->deallocate(_head, _head->size, alignof(Block));
+            _head = next;
+        }
+        _cur = _end = nullptr;
+        _used = 0;
+    }
+
+    // Сколько байт выдано пользователям арены
+    size_t bytes_used() const noexcept { return _used; }
+
+private:
+    struct Block {
+        Block* next;
+        size_t size;
+    };
+
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        std::byte* p = align_up(_cur, alignment);
+        if (!_cur || p + bytes > _end) {
+            // Большие запросы получают собственный блок
+            const size_t need = sizeof(Block) + bytes + alignment;
+            const size_t size = std::max(_block_size, need);
+            auto* block = static_cast<Block*>(_upstream->allocate(size, alignof(Block)));
+            block->next = _head;
+            block->size = size;
+            _head = block;
+            _cur = reinterpret_cast<std::byte*>(block + 1);
+            _end = reinterpret_cast<std::byte*>(block) + size;
+            p = align_up(_cur, alignment);
+        }
+        _cur = p + bytes;
+        _used += bytes;
+        return p;
+    }
+
+    void do_deallocate(void*, size_t, size_t) override {}
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+    static std::byte* align_up(std::byte* p, size_t alignment) {
+        const auto v = reinterpret_cast<std::uintptr_t>(p);
+        return reinterpret_cast<std::byte*>((v + alignment - 1) & ~(std::uintptr_t(alignment) - 1));
+    }
+
+    size_t _block_size;
+    std::pmr::memory_resource* _upstream;
+    Block* _head = nullptr;
+    std::byte* _cur = nullptr;
+    std::byte* _end = nullptr;
+    size_t _used = 0;
+};
+
+// make_shared внутри ресурса: объект, блок счётчика и (если фигура умеет
+// принимать ресурс) её точки размещаются в resource
+template<class F, class... Args>
+std::shared_ptr<F> make_shared_in(std::pmr::memory_resource& resource, Args&&... args) {
+    std::pmr::polymorphic_allocator<F> alloc(&resource);
+    if constexpr (std::is_constructible_v<F, std::pmr::memory_resource*, Args...>) {
+        return std::allocate_shared<F>(alloc, &resource, std::forward<Args>(args)...);
+    } else {
+        return std::allocate_shared<F>(alloc, std::forward<Args>(args)...);
+    }
+}
@@ -1,24 +1,54 @@
+#pragma once
 #include <memory>
 #include <utility>
 #include <algorithm>
+#include <cstring>
+#include <initializer_list>
 #include <stdexcept>
 #include <type_traits>
+#include "instrument.h"
 
+// Тип можно переносить в новую память простым memcpy, не вызывая
+// конструктор перемещения и деструктор. По умолчанию это тривиально
+// копируемые типы, умные указатели тоже можно так переносить
 template <typename T>
-concept Arrayable = std::is_default_constructible_v<T>;
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+template <typename T>
+struct is_trivially_relocatable<std::shared_ptr<T>> : std::true_type {};
+
+template <typename T>
+struct is_trivially_relocatable<std::unique_ptr<T>> : std::true_type {};
+
+template <typename T>
+inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+template <typename T>
+concept Arrayable = std::is_nothrow_destructible_v<T> &&
+    (std::is_move_constructible_v<T> || std::is_copy_constructible_v<T>);
 
 // template<class T> Array {....}
+// Память под элементы выделяется без их конструирования, элементы создаются
+// на месте и уничтожаются при clear/pop_back/erase
 template <Arrayable T>
 class Array {
 public:
+    using value_type = T;
+    using iterator = T*;
+    using const_iterator = const T*;
+
     Array() noexcept : _size(0), _capacity(0), _data(nullptr) {}
 
+    Array(std::initializer_list<T> values) : Array() {
+        reserve(values.size());
+        for (const T& v : values) std::construct_at(_data + _size++, v);
+    }
+
     // Копирующий конструктор
-    Array(const Array& other) : _size(other._size), _capacity(other._capacity) {
-        if (_capacity) {
-            _data = std::make_unique<T[]>(_capacity);
-            for (size_t i = 0; i < _size; ++i) _data[i] = other._data[i];
-        }
+    Array(const Array& other) : Array() {
+        reserve(other._size);
+        std::uninitialized_copy_n(other._data, other._size, _data);
+        _size = other._size;
     }
 
     Array& operator=(const Array& other) {
@@ -28,22 +58,22 @@ public:
         return *this;
     }
 
-    Array(Array&& other) noexcept : _size(other._size), _capacity(other._capacity), _data(std::move(other._data)) {
-        other._size = 0;
-        other._capacity = 0;
-    }
+    Array(Array&& other) noexcept
+        : _size(std::exchange(other._size, 0)),
+          _capacity(std::exchange(other._capacity, 0)),
+          _data(std::exchange(other._data, nullptr)) {}
 
     // Перемещающий оператор присваивания
     Array& operator=(Array&& other) noexcept {
         if (this == &other) return *this;
-        _size = other._size;
-        _capacity = other._capacity;
-        _data = std::move(other._data);
-        other._size = other._capacity = 0;
+        destroy_and_free();
+        _size = std::exchange(other._size, 0);
+        _capacity = std::exchange(other._capacity, 0);
+        _data = std::exchange(other._data, nullptr);
         return *this;
     }
 
-    ~Array() = default;
+    ~Array() { destroy_and_free(); }
 
     T& operator[](size_t idx) {
         if (idx >= _size) throw std::out_of_range("Array index out of range");
@@ -54,44 +84,105 @@ public:
         return _data[idx];
     }
 
+    T& back() { return (*this)[_size - 1]; }
+    const T& back() const { return (*this)[_size - 1]; }
+
+    T* data() noexcept { return _data; }
+    const T* data() const noexcept { return _data; }
+
+    iterator begin() noexcept { return _data; }
+    iterator end() noexcept { return _data + _size; }
+    const_iterator begin() const noexcept { return _data; }
+    const_iterator end() const noexcept { return _data + _size; }
+
     size_t size() const noexcept {return _size;}
     size_t capacity() const noexcept {return _capacity;}
     bool empty() const noexcept {return _size == 0;}
 
     void reserve(size_t new_capacity) {
         if (new_capacity <= _capacity) return;
-        std::unique_ptr<T[]> new_data = std::make_unique<T[]>(new_capacity);
-        for (size_t i = 0; i < _size; ++i) {
-            new_data[i] = std::move(_data[i]);
+        FIGURE_TIMED(ArrayRealloc, new_capacity * sizeof(T));
+        T* new_data = allocate(new_capacity);
+        try {
+            relocate(_data, _size, new_data);
+        } catch (...) {
+            // Созданные копии разрушил uninitialized_copy_n, старый буфер цел
+            deallocate(new_data, new_capacity);
+            throw;
         }
-        _data = std::move(new_data);
+        deallocate(_data, _capacity);
+        _data = new_data;
         _capacity = new_capacity;
     }
 
-    void resize(size_t new_size) {
-        if (new_size > _capacity) {
-            reserve(new_size);
-        }
+    void resize(size_t new_size) requires std::is_default_constructible_v<T> {
+        if (new_size > _capacity) reserve(new_size);
+        if (new_size > _size) std::uninitialized_value_construct_n(_data + _size, new_size - _size);
+        else std::destroy(_data + new_size, _data + _size);
+        _size = new_size;
+    }
+
+    void resize(size_t new_size, const T& value) {
+        if (new_size > _capacity) reserve(new_size);
+        if (new_size > _size) std::uninitialized_fill_n(_data + _size, new_size - _size, value);
+        else std::destroy(_data + new_size, _data + _size);
         _size = new_size;
     }
 
     void clear() noexcept {
+        std::destroy_n(_data, _size);
         _size = 0;
     }
 
     void pop_back() {
         if (_size == 0) return;
-        --_size;
+        std::destroy_at(_data + --_size);
+    }
+
+    template <typename... Args>
+    T& emplace_back(Args&&... args) {
+        if (_size == _capacity) return grow_and_emplace(std::forward<Args>(args)...);
+        T* p = std::construct_at(_data + _size, std::forward<Args>(args)...);
+        ++_size;
+        return *p;
     }
 
-    void push_back(const T& value) {
-        if (_size == _capacity) reserve(std::max<size_t>(1, _capacity * 2));
-        _data[_size++] = value; 
+    void push_back(const T& value) { emplace_back(value); }
+
+    void push_back(T&& value) { emplace_back(std::move(value)); }
+
+    // Вставка перед pos, возвращает итератор на вставленный элемент
+    template <typename... Args>
+    iterator emplace(const_iterator pos, Args&&... args) {
+        const size_t idx = check_position(pos);
+        if (idx == _size) {
+            emplace_back(std::forward<Args>(args)...);
+            return _data + idx;
+        }
+        // Значение создаём заранее: args может ссылаться на элемент массива
+        T value(std::forward<Args>(args)...);
+        if (_size == _capacity) reserve(next_capacity());
+        std::construct_at(_data + _size, std::move_if_noexcept(_data[_size - 1]));
+        std::move_backward(_data + idx, _data + _size - 1, _data + _size);
+        ++_size;
+        _data[idx] = std::move(value);
+        return _data + idx;
     }
 
-    void push_back(T&& value) {
-        if (_size == _capacity) reserve(std::max<size_t>(1, _capacity * 2));
-        _data[_size++] = std::move(value);
+    iterator insert(const_iterator pos, const T& value) { return emplace(pos, value); }
+    iterator insert(const_iterator pos, T&& value) { return emplace(pos, std::move(value)); }
+
+    iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+
+    iterator erase(const_iterator first, const_iterator last) {
+        const size_t from = check_position(first);
+        const size_t to = check_position(last);
+        if (from > to) throw std::out_of_range("Array erase range is invalid");
+        if (from == to) return _data + from;
+        T* new_end = std::move(_data + to, _data + _size, _data + from);
+        std::destroy(new_end, _data + _size);
+        _size -= to - from;
+        return _data + from;
     }
 
     void swap(Array& other) noexcept {
@@ -101,7 +192,75 @@ public:
     }
 
 private:
+    static T* allocate(size_t n) {
+        FIGURE_TIMED(ArrayAlloc, n * sizeof(T));
+        return std::allocator<T>().allocate(n);
+    }
+
+    static void deallocate(T* p, size_t n) noexcept {
+        if (p) std::allocator<T>().deallocate(p, n);
+    }
+
+    // Перенос n элементов в неинициализированную память dst; в src после
+    // этого остаётся неинициализированная память
+    static void relocate(T* src, size_t n, T* dst) {
+        if (n == 0) return;
+        if constexpr (is_trivially_relocatable_v<T>) {
+            std::memcpy(static_cast<void*>(dst), static_cast<const void*>(src), n * sizeof(T));
+        } else if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>) {
+            std::uninitialized_move_n(src, n, dst);
+            std::destroy_n(src, n);
+        } else {
+            // Перемещение может бросить исключение - копируем, чтобы при
+            // ошибке старый буфер остался целым
+            std::uninitialized_copy_n(src, n, dst);
+            std::destroy_n(src, n);
+        }
+    }
+
+    size_t next_capacity() const { return std::max<size_t>(1, _capacity * 2); }
+
+    template <typename... Args>
+    T& grow_and_emplace(Args&&... args) {
+        const size_t new_capacity = next_capacity();
+        FIGURE_TIMED(ArrayRealloc, new_capacity * sizeof(T));
+        T* new_data = allocate(new_capacity);
+        T* p;
+        try {
+            // Новый элемент создаём до переноса старых: args может ссылаться
+            // на элемент этого же массива
+            p = std::construct_at(new_data + _size, std::forward<Args>(args)...);
+        } catch (...) {
+            deallocate(new_data, new_capacity);
+            throw;
+        }
+        try {
+            relocate(_data, _size, new_data);
+        } catch (...) {
+            std::destroy_at(p);
+            deallocate(new_data, new_capacity);
+            throw;
+        }
+        deallocate(_data, _capacity);
+        _data = new_data;
+        _capacity = new_capacity;
+        ++_size;
+        return *p;
+    }
+
+    size_t check_position(const_iterator pos) const {
+        if (pos < _data || pos > _data + _size) throw std::out_of_range("Array iterator out of range");
+        return static_cast<size_t>(pos - _data);
+    }
+
+    void destroy_and_free() noexcept {
+        std::destroy_n(_data, _size);
+        deallocate(_data, _capacity);
+        _data = nullptr;
+        _size = _capacity = 0;
+    }
+
     size_t _size;
     size_t _capacity;
-    std::unique_ptr<T[]> _data;
-};
\ No newline at end of file
+    T* _data;
+};
@@ -1,82 +1,238 @@
 #pragma once
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <memory>
+#include <memory_resource>
+#include <ranges>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include "geometry.h"
+#include "instrument.h"
 #include "point.h"
 
-// PointContainer для хранения точек с использованием уникальных указателей
-// и односвязного списка
-template<class P>
+// PointContainer хранит точки подряд в памяти (small buffer optimization):
+// первые InlineN точек лежат прямо внутри объекта без аллокаций, при
+// переполнении всё переезжает в кучу с удвоением ёмкости.
+// push_back и operator[] работают за O(1).
+// Память в куче берётся из memory_resource (по умолчанию обычный new/delete),
+// так что точки можно разместить в арене вместе с фигурой. При перемещении
+// ресурс переезжает вместе с буфером.
+// Буфер в куче разделяемый (copy-on-write): копия контейнера только
+// увеличивает счётчик ссылок, а свой буфер появляется при первом изменении
+// (push_back, reserve, неконстантный доступ к точкам). Так делятся только
+// буферы из new_delete_resource, который живёт всю программу; буфер из
+// арены или другого ресурса копия не наследует и копирует точки в
+// get_default_resource(), иначе она пережила бы арену. Встроенные точки
+// копируются сразу - их не больше InlineN.
+// После неконстантного доступа наружу могла уйти ссылка на точку, поэтому
+// буфер помечается неразделяемым (как делала старая COW std::string), и
+// копии такого контейнера копируют точки сразу
+template<class P, size_t InlineN = 5>
 class PointContainer {
 private:
-    struct Node {
-        std::unique_ptr<P> point;
-        Node* next;
-        Node(std::unique_ptr<P> p) : point(std::move(p)), next(nullptr) {}
+    // Заголовок буфера в куче, точки лежат сразу за ним. Буфер помнит свой
+    // ресурс, потому что его может освобождать другой контейнер
+    struct Block {
+        std::atomic<size_t> refs;
+        size_t capacity;
+        std::pmr::memory_resource* resource;
+        // Сбрасывается, когда отданы изменяемые ссылки на точки
+        bool shareable;
     };
 
-    Node* head = nullptr;
+    static constexpr size_t block_align = std::max(alignof(Block), alignof(P));
+    static constexpr size_t header_size = (sizeof(Block) + alignof(P) - 1) / alignof(P) * alignof(P);
+
+    alignas(P) unsigned char _inline[InlineN * sizeof(P)];
+    P* _data = inline_data();
     size_t _size = 0;
+    size_t _capacity = InlineN;
+    std::pmr::memory_resource* _resource = std::pmr::get_default_resource();
+
+    P* inline_data() noexcept { return reinterpret_cast<P*>(_inline); }
+    bool is_inline() const noexcept {
+        return _data == reinterpret_cast<const P*>(_inline);
+    }
+
+    Block* block() const noexcept {
+        return reinterpret_cast<Block*>(reinterpret_cast<unsigned char*>(_data) - header_size);
+    }
+
+    P* allocate_block(size_t capacity) {
+        FIGURE_TIMED(ContainerAlloc, capacity * sizeof(P));
+        void* raw = _resource->allocate(header_size + capacity * sizeof(P), block_align);
+        ::new (raw) Block{{1}, capacity, _resource, true};
+        return reinterpret_cast<P*>(static_cast<unsigned char*>(raw) + header_size);
+    }
+
+    // Отпускаем буфер; последний владелец разрушает точки и освобождает память
+    void release() noexcept {
+        if (is_inline()) {
+            std::destroy_n(_data, _size);
+            return;
+        }
+        Block* b = block();
+        if (b->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+        std::destroy_n(_data, _size);
+        const size_t capacity = b->capacity;
+        std::pmr::memory_resource* resource = b->resource;
+        b->~Block();
+        resource->deallocate(b, header_size + capacity * sizeof(P), block_align);
+    }
+
+    void destroy_all() noexcept {
+        release();
+        _data = inline_data();
+        _size = 0;
+        _capacity = InlineN;
+    }
+
+    // Переезд в новый буфер ёмкостью new_capacity; из своего буфера точки
+    // переносятся, из общего - копируются. Следом дописываются extra[0, n):
+    // они могут лежать в старом буфере (add_point(get_point(0))), поэтому
+    // старый буфер отпускается только после копирования
+    void reallocate(size_t new_capacity, const P* extra = nullptr, size_t n = 0) {
+        P* new_data = allocate_block(new_capacity);
+        if (is_shared()) {
+            std::uninitialized_copy_n(_data, _size, new_data);
+        } else {
+            std::uninitialized_move_n(_data, _size, new_data);
+        }
+        std::uninitialized_copy_n(extra, n, new_data + _size);
+        release();
+        _data = new_data;
+        _capacity = new_capacity;
+        _size += n;
+    }
+
+    // Перед изменением точек: свой буфер вместо общего, с дописанными extra
+    void detach(size_t min_capacity, const P* extra = nullptr, size_t n = 0) {
+        if (is_shared()) {
+            reallocate(std::max(_capacity, min_capacity), extra, n);
+        } else if (min_capacity > _capacity) {
+            reallocate(min_capacity, extra, n);
+        } else {
+            std::uninitialized_copy_n(extra, n, _data + _size);
+            _size += n;
+        }
+    }
+
+    // Забираем содержимое other; других данных у this быть не должно
+    void steal(PointContainer& other) noexcept {
+        _resource = other._resource;
+        if (other.is_inline()) {
+            std::uninitialized_move_n(other._data, other._size, _data);
+            std::destroy_n(other._data, other._size);
+        } else {
+            _data = other._data;
+            _capacity = other._capacity;
+            other._data = other.inline_data();
+            other._capacity = InlineN;
+        }
+        _size = other._size;
+        other._size = 0;
+    }
 
 public:
     PointContainer() = default;
 
-    ~PointContainer() {
-        while (head) {
-            Node* temp = head;
-            head = head->next;
-            delete temp;
+    explicit PointContainer(std::pmr::memory_resource* resource) : _resource(resource) {}
+
+    ~PointContainer() { destroy_all(); }
+
+    // Копия берёт память из ресурса по умолчанию, как и раньше, а буфер
+    // оригинала делит, только если он из new_delete_resource и не помечен
+    // неразделяемым
+    PointContainer(const PointContainer& other) {
+        if (other.is_inline()) {
+            std::uninitialized_copy_n(other._data, other._size, _data);
+        } else if (other.block()->shareable && other.block()->resource == std::pmr::new_delete_resource()) {
+            other.block()->refs.fetch_add(1, std::memory_order_relaxed);
+            _data = other._data;
+            _capacity = other._capacity;
+        } else if (other._size > InlineN) {
+            _data = allocate_block(other._size);
+            _capacity = other._size;
+            std::uninitialized_copy_n(other._data, other._size, _data);
+        } else {
+            std::uninitialized_copy_n(other._data, other._size, _data);
         }
+        _size = other._size;
     }
 
-    // Умные указатели запрещают копирование
-    PointContainer(const PointContainer&) = delete;
-    PointContainer& operator=(const PointContainer&) = delete;
+    // Ресурс для новых выделений остаётся своим
+    PointContainer& operator=(const PointContainer& other) {
+        if (this != &other) {
+            PointContainer tmp(other);
+            tmp._resource = _resource;
+            *this = std::move(tmp);
+        }
+        return *this;
+    }
 
     // Разрешаем перемещение
-    PointContainer(PointContainer&& other) noexcept
-        : head(other.head), _size(other._size)
-    {
-        other.head = nullptr;
-        other._size = 0;
-    }
+    PointContainer(PointContainer&& other) noexcept { steal(other); }
 
     // Перемещающий оператор присваивания
     PointContainer& operator=(PointContainer&& other) noexcept {
         if (this != &other) {
-            while (head) { Node* t = head; head = head->next; delete t; }
-            head = other.head;
-            _size = other._size;
-            other.head = nullptr;
-            other._size = 0;
+            destroy_all();
+            steal(other);
         }
         return *this;
     }
 
+    void reserve(size_t new_capacity) {
+        if (new_capacity <= _capacity) return;
+        reallocate(new_capacity);
+    }
+
+    // point может быть ссылкой на собственную точку контейнера
+    void push_back(const P& point) {
+        detach(_size == _capacity ? _capacity * 2 : _capacity, &point, 1);
+    }
+
     void push_back(std::unique_ptr<P> point) {
-        Node* newNode = new Node(std::move(point));
-        if (!head) head = newNode;
-        else {
-            Node* cur = head;
-            while (cur->next) cur = cur->next;
-            cur->next = newNode;
-        }
-        ++_size;
+        push_back(*point);
+    }
+
+    // Добавление n точек подряд: не больше одного выделения памяти
+    void append(const P* first, size_t n) {
+        detach(_size + n, first, n);
     }
 
     size_t size() const { return _size; }
+    size_t capacity() const { return _capacity; }
+    std::pmr::memory_resource* resource() const noexcept { return _resource; }
+
+    // Буфер в куче есть и у других контейнеров
+    bool is_shared() const noexcept {
+        return !is_inline() && block()->refs.load(std::memory_order_acquire) > 1;
+    }
+
+    // Неконстантный доступ может изменить точки, поэтому отделяет буфер, а
+    // ссылки на точки могут пережить вызов, поэтому буфер больше не делится
+    P* data() {
+        detach(_capacity);
+        if (!is_inline()) block()->shareable = false;
+        return _data;
+    }
+    const P* data() const noexcept { return _data; }
+    P* begin() { return data(); }
+    P* end() { return data() + _size; }
+    const P* begin() const noexcept { return _data; }
+    const P* end() const noexcept { return _data + _size; }
 
     P& operator[](size_t index) {
         if (index >= _size) throw std::out_of_range("Index out of range");
-        Node* cur = head;
-        for (size_t i = 0; i < index; ++i) cur = cur->next;
-        return *(cur->point);
+        return data()[index];
     }
 
     const P& operator[](size_t index) const {
         if (index >= _size) throw std::out_of_range("Index out of range");
-        Node* cur = head;
-        for (size_t i = 0; i < index; ++i) cur = cur->next;
-        return *(cur->point);
+        return _data[index];
     }
 };
 
@@ -86,28 +242,47 @@ public:
     using P = Point<T>;
 
     Figure() = default;
+    // Точки, не поместившиеся внутрь фигуры, будут браться из resource
+    explicit Figure(std::pmr::memory_resource* resource) : points(resource) {}
     virtual ~Figure() noexcept = default;
 
-    Figure(const Figure<T>& other) {
-        for (size_t i = 0; i < other.get_points_count(); ++i) {
-            points.push_back(std::make_unique<P>(other.get_point(i)));
-        }
+    // Копия делит точки из кучи с оригиналом (copy-on-write), так что
+    // копирование большой фигуры - это увеличение счётчика ссылок; в счётчик
+    // FigureCopy идут только реально скопированные встроенные точки
+    Figure(const Figure<T>& other) : points(other.points), _cache(other._cache), _dirty(other._dirty) {
+        FIGURE_COUNT(FigureCopy, copied_bytes());
     }
 
+    // Ресурс для будущих выделений остаётся своим
     Figure<T>& operator=(const Figure<T>& other) {
         if (this == &other) return *this;
-        PointContainer<Point<T>> tmp;
-        for (size_t i = 0; i < other.get_points_count(); ++i) {
-            tmp.push_back(std::make_unique<P>(other.get_point(i)));
-        }
-        this->points = std::move(tmp);
+        this->points = other.points;
+        FIGURE_COUNT(FigureCopy, copied_bytes());
+        _cache = other._cache;
+        _dirty = other._dirty;
         return *this;
     }
 
-    Figure(Figure<T>&& other) noexcept = default;
+    Figure(Figure<T>&& other) noexcept
+        : points(std::move(other.points)),
+          _cache(std::exchange(other._cache, PolygonAccumulator<T>())),
+          _dirty(std::exchange(other._dirty, false)) {}
 
     void add_point(const P& point) {
-        points.push_back(std::make_unique<P>(point));
+        // point может лежать в points и переехать вместе с ними
+        const P copy = point;
+        points.push_back(copy);
+        if (!_dirty) _cache.add(copy);
+    }
+
+    // Добавление многих точек: кэш пересчитывается один раз в конце,
+    // память под точки выделяется заранее, если размер диапазона известен
+    template<class Range>
+    void add_points(const Range& range) {
+        mark_dirty();
+        if constexpr (std::ranges::sized_range<const Range>) points.reserve(points.size() + std::ranges::size(range));
+        for (const auto& p : range) points.push_back(p);
+        refresh();
     }
 
     size_t get_points_count() const {
@@ -118,6 +293,43 @@ public:
         return points[index];
     }
 
+    // Все точки подряд, без копирования
+    std::span<const P> vertices() const noexcept { return {points.data(), points.size()}; }
+
+    // Кэшированные площадь, центроид и габариты. Обновляются за O(1) в
+    // add_point, так что запросы не проходят по всем точкам.
+    // Если точки меняются напрямую (наследники работают с points), нужно
+    // вызвать mark_dirty(), а после правок - refresh(). Пока кэш помечен
+    // грязным, запросы считают всё заново, ничего не записывая
+    double signed_area() const { return cache().signed_area(); }
+    double area() const {
+        FIGURE_TIMED(Area, 0);
+        return cache().area();
+    }
+    Point<double> centroid() const { return cache().centroid(); }
+    Bounds<T> bounds() const { return cache().bounds(); }
+
+    // Площадь с выбранной политикой арифметики (ExactArithmetic,
+    // CompensatedArithmetic), считается заново без кэша
+    template<class Policy>
+    double area() const {
+        FIGURE_TIMED(Area, 0);
+        return shoelace_area<Policy>(points.size(), [this](size_t i) -> const P& { return points[i]; });
+    }
+
+    // Точная удвоенная площадь для целых координат
+    geometry_detail::int128_t twice_area_exact() const requires std::is_integral_v<T> {
+        return exact_twice_area(points.size(), [this](size_t i) -> const P& { return points[i]; });
+    }
+
+    void mark_dirty() noexcept { _dirty = true; }
+    bool is_dirty() const noexcept { return _dirty; }
+
+    void refresh() {
+        _cache = rebuild_cache();
+        _dirty = false;
+    }
+
     virtual P center() const = 0;
     virtual operator double() = 0;
 
@@ -132,4 +344,20 @@ public:
 
 protected:
     PointContainer<P> points;
+
+private:
+    size_t copied_bytes() const noexcept { return points.is_shared() ? 0 : points.size() * sizeof(P); }
+
+    PolygonAccumulator<T> rebuild_cache() const {
+        PolygonAccumulator<T> acc;
+        for (const P& p : points) acc.add(p);
+        return acc;
+    }
+
+    PolygonAccumulator<T> cache() const {
+        return _dirty ? rebuild_cache() : _cache;
+    }
+
+    PolygonAccumulator<T> _cache;
+    bool _dirty = false;
 };
\ No newline at end of file
@@ -0,0 +1,268 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "store.h"
+
+// Двоичный формат файла с фигурами (все числа в порядке байт машины,
+// порядок проверяется по endian_tag):
+//
+//   FigureFileHeader                  64 байта
+//   kinds[figure_count]               uint8_t, FigureKind
+//   offsets[figure_count + 1]         uint64_t, индекс первой вершины фигуры
+//   xs[vertex_count]                  T
+//   ys[vertex_count]                  T
+//
+// Каждая колонка начинается с границы 8 байт, поэтому после mmap их можно
+// читать напрямую, ничего не копируя
+
+enum class CoordKind : uint8_t {
+    Signed = 0,
+    Unsigned = 1,
+    Floating = 2,
+};
+
+struct FigureFileHeader {
+    char magic[4];
+    uint16_t version;
+    uint8_t coord_size;
+    CoordKind coord_kind;
+    uint32_t endian_tag;
+    uint32_t reserved0;
+    uint64_t figure_count;
+    uint64_t vertex_count;
+    uint64_t reserved[4];
+};
+static_assert(sizeof(FigureFileHeader) == 64);
+
+inline constexpr char kFigureFileMagic[4] = {'S', 'L', 'F', 'G'};
+inline constexpr uint16_t kFigureFileVersion = 1;
+inline constexpr uint32_t kFigureFileEndianTag = 0x01020304;
+
+template<class T>
+constexpr CoordKind coord_kind_of() {
+    if constexpr (std::is_floating_point_v<T>) return CoordKind::Floating;
+    else if constexpr (std::is_signed_v<T>) return CoordKind::Signed;
+    else return CoordKind::Unsigned;
+}
+
+// Смещения колонок относительно начала файла
+struct FigureFileLayout {
+    uint64_t kinds;
+    uint64_t offsets;
+    uint64_t xs;
+    uint64_t ys;
+    uint64_t end;
+
+    static constexpr uint64_t align8(uint64_t n) { return (n + 7) & ~uint64_t(7); }
+
+    static FigureFileLayout make(uint64_t figures, uint64_t vertices, size_t coord_size) {
+        FigureFileLayout l{};
+        l.kinds = sizeof(FigureFileHeader);
+        l.offsets = align8(l.kinds + figures);
+        l.xs = l.offsets + (figures + 1) * sizeof(uint64_t);
+        l.ys = align8(l.xs + vertices * coord_size);
+        l.end = align8(l.ys + vertices * coord_size);
+        return l;
+    }
+};
+
+// Запись хранилища в поток в двоичном формате
+template<Pointable T>
+void write_figures(std::ostream& os, const FigureStore<T>& store) {
+    FigureFileHeader header{};
+    std::memcpy(header.magic, kFigureFileMagic, sizeof(header.magic));
+    header.version = kFigureFileVersion;
+    header.coord_size = sizeof(T);
+    header.coord_kind = coord_kind_of<T>();
+    header.endian_tag = kFigureFileEndianTag;
+    header.figure_count = store.size();
+    header.vertex_count = store.vertex_count();
+
+    const auto layout = FigureFileLayout::make(store.size(), store.vertex_count(), sizeof(T));
+    uint64_t written = 0;
+    auto put = [&](const void* data, uint64_t bytes) {
+        os.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+        written += bytes;
+    };
+    auto pad_to = [&](uint64_t pos) {
+        static const char zeros[8] = {};
+        put(zeros, pos - written);
+    };
+
+    put(&header, sizeof(header));
+    put(store.kinds().data(), store.size());
+    pad_to(layout.offsets);
+    if constexpr (sizeof(size_t) == sizeof(uint64_t)) {
+        put(store.offsets().data(), store.offsets().size_bytes());
+    } else {
+        for (size_t off : store.offsets()) {
+            const uint64_t v = off;
+            put(&v, sizeof(v));
+        }
+    }
+    put(store.xs().data(), store.xs().size_bytes());
+    pad_to(layout.ys);
+    put(store.ys().data(), store.ys().size_bytes());
+    pad_to(layout.end);
+    if (!os) throw std::runtime_error("Failed to write figure file");
+}
+
+template<Pointable T>
+void write_figures(const std::string& path, const FigureStore<T>& store) {
+    std::ofstream os(path, std::ios::binary | std::ios::trunc);
+    if (!os) throw std::runtime_error("Cannot open " + path + " for writing");
+    write_figures(os, store);
+}
+
+// Файл фигур, отображённый в память. Фигуры доступны как StoredFigure
+// прямо поверх отображения, без создания объектов Figure и без копирования
+template<Pointable T>
+class MappedFigureFile {
+public:
+    explicit MappedFigureFile(const std::string& path) {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("Cannot open " + path);
+        struct stat st {};
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Cannot stat " + path);
+        }
+        _bytes = static_cast<size_t>(st.st_size);
+        if (_bytes < sizeof(FigureFileHeader)) {
+            ::close(fd);
+            throw std::runtime_error(path + ": file is too small");
+        }
+        void* addr = ::mmap(nullptr, _bytes, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (addr == MAP_FAILED) throw std::runtime_error("Cannot mmap " + path);
+        _base = static_cast<const unsigned char*>(addr);
+        try {
+            validate(path);
+        } catch (...) {
+            unmap();
+            throw;
+        }
+    }
+
+    ~MappedFigureFile() { unmap(); }
+
+    MappedFigureFile(const MappedFigureFile&) = delete;
+    MappedFigureFile& operator=(const MappedFigureFile&) = delete;
+
+    MappedFigureFile(MappedFigureFile&& other) noexcept
+        : _base(std::exchange(other._base, nullptr)), _bytes(std::exchange(other._bytes, 0)),
+          _figures(other._figures), _vertices(other._vertices),
+          _kinds(other._kinds), _offsets(other._offsets), _xs(other._xs), _ys(other._ys) {}
+
+    MappedFigureFile& operator=(MappedFigureFile&& other) noexcept {
+        if (this != &other) {
+            unmap();
+            _base = std::exchange(other._base, nullptr);
+            _bytes = std::exchange(other._bytes, 0);
+            _figures = other._figures;
+            _vertices = other._vertices;
+            _kinds = other._kinds;
+            _offsets = other._offsets;
+            _xs = other._xs;
+            _ys = other._ys;
+        }
+        return *this;
+    }
+
+    size_t size() const noexcept { return _figures; }
+    size_t vertex_count() const noexcept { return _vertices; }
+    bool empty() const noexcept { return _figures == 0; }
+
+    StoredFigure<T> operator[](size_t idx) const {
+        if (idx >= _figures) throw std::out_of_range("MappedFigureFile index out of range");
+        const uint64_t first = _offsets[idx];
+        const uint64_t last = _offsets[idx + 1];
+        const FigureKind kind = _kinds[idx];
+        if (static_cast<uint8_t>(kind) > static_cast<uint8_t>(FigureKind::Pentagon) ||
+            first > last || last > _vertices || last - first != figure_arity(kind)) {
+            throw std::runtime_error("Corrupted figure file offsets");
+        }
+        return StoredFigure<T>(kind, last - first, _xs + first, _ys + first);
+    }
+
+    double total_area() const {
+        double total = 0;
+        for (size_t i = 0; i < _figures; ++i) total += (*this)[i].area();
+        return total;
+    }
+
+    // Копия в FigureStore, если нужно дальше работать с пакетными функциями
+    FigureStore<T> load() const {
+        FigureStore<T> store;
+        store.reserve(_figures, _vertices);
+        Point<T> points[5];
+        for (size_t i = 0; i < _figures; ++i) {
+            const StoredFigure<T> f = (*this)[i];
+            for (size_t j = 0; j < f.size(); ++j) points[j] = Point<T>(f.xs()[j], f.ys()[j]);
+            store.push_back(f.kind(), std::span<const Point<T>>(points, f.size()));
+        }
+        return store;
+    }
+
+    std::span<const FigureKind> kinds() const noexcept { return {_kinds, _figures}; }
+    std::span<const uint64_t> offsets() const noexcept { return {_offsets, _figures + 1}; }
+    std::span<const T> xs() const noexcept { return {_xs, _vertices}; }
+    std::span<const T> ys() const noexcept { return {_ys, _vertices}; }
+
+private:
+    void validate(const std::string& path) {
+        FigureFileHeader header;
+        std::memcpy(&header, _base, sizeof(header));
+        if (std::memcmp(header.magic, kFigureFileMagic, sizeof(header.magic)) != 0) {
+            throw std::runtime_error(path + ": not a figure file");
+        }
+        if (header.version != kFigureFileVersion) {
+            throw std::runtime_error(path + ": unsupported figure file version");
+        }
+        if (header.endian_tag != kFigureFileEndianTag) {
+            throw std::runtime_error(path + ": figure file has different byte order");
+        }
+        if (header.coord_size != sizeof(T) || header.coord_kind != coord_kind_of<T>()) {
+            throw std::runtime_error(path + ": coordinate type mismatch");
+        }
+        // Защита от переполнения при вычислении размеров колонок
+        if (header.figure_count > _bytes || header.vertex_count > _bytes) {
+            throw std::runtime_error(path + ": file is truncated");
+        }
+        const auto layout = FigureFileLayout::make(header.figure_count, header.vertex_count, sizeof(T));
+        if (layout.end > _bytes) throw std::runtime_error(path + ": file is truncated");
+
+        _figures = header.figure_count;
+        _vertices = header.vertex_count;
+        _kinds = reinterpret_cast<const FigureKind*>(_base + layout.kinds);
+        _offsets = reinterpret_cast<const uint64_t*>(_base + layout.offsets);
+        _xs = reinterpret_cast<const T*>(_base + layout.xs);
+        _ys = reinterpret_cast<const T*>(_base + layout.ys);
+    }
+
+    void unmap() noexcept {
+        if (_base) ::munmap(const_cast<unsigned char*>(_base), _bytes);
+        _base = nullptr;
+        _bytes = 0;
+    }
+
+    const unsigned char* _base = nullptr;
+    size_t _bytes = 0;
+    size_t _figures = 0;
+    size_t _vertices = 0;
+    const FigureKind* _kinds = nullptr;
+    const uint64_t* _offsets = nullptr;
+    const T* _xs = nullptr;
+    const T* _ys = nullptr;
+};
@@ -0,0 +1,436 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "array.h"
+#include "figure_view.h"
+#include "figures.h"
+
+// Пересечение, объединение и разность многоугольников.
+// Для пересечения выпуклых фигур используется Сазерленд-Ходжмен, для
+// остального - наложение рёбер: рёбра обеих фигур режутся в точках
+// пересечения (общая точка вычисляется один раз и попадает в обе фигуры),
+// каждый кусок классифицируется как внутренний/внешний/общий, нужные куски
+// сшиваются в контуры. Общие рёбра и касания в вершинах обрабатываются
+// явно, без сдвига вершин. Фигуры должны быть простыми (без
+// самопересечений); сложность O(n*m), для наших 4-5 вершин это немного.
+// Вычисления в double: для целых координат по модулю до 2^26 все
+// предикаты точные
+
+enum class ClipOp : uint8_t {
+    Intersection,
+    Union,
+    Difference,
+};
+
+// Результат отсечения: контуры подряд в одном массиве точек. Внешние контуры
+// обходятся против часовой стрелки, дыры - по часовой, поэтому сумма
+// ориентированных площадей контуров равна площади результата.
+// Контуры разбиты на группы - по одной на каждый вызов Clipper::clip
+class ClipResult {
+public:
+    ClipResult() { clear(); }
+
+    // Память не освобождается, результат можно переиспользовать
+    void clear() {
+        _points.clear();
+        _rings.assign(1, 0);
+        _groups.assign(1, 0);
+    }
+
+    size_t size() const noexcept { return _rings.size() - 1; }
+    bool empty() const noexcept { return size() == 0; }
+
+    PolygonSpan<double> operator[](size_t ring) const {
+        if (ring >= size()) throw std::out_of_range("Ring index out of range");
+        return PolygonSpan<double>(std::span<const Point<double>>(_points).subspan(_rings[ring], _rings[ring + 1] - _rings[ring]));
+    }
+
+    double signed_area(size_t ring) const {
+        return (*this)[ring].accumulate().signed_area();
+    }
+
+    double area() const { return rings_area(0, size()); }
+
+    size_t group_count() const noexcept { return _groups.size() - 1; }
+
+    // Контуры группы g: [first, last)
+    std::pair<size_t, size_t> group(size_t g) const {
+        if (g >= group_count()) throw std::out_of_range("Group index out of range");
+        return {_groups[g], _groups[g + 1]};
+    }
+
+    double group_area(size_t g) const {
+        const auto [first, last] = group(g);
+        return rings_area(first, last);
+    }
+
+    std::span<const Point<double>> points() const noexcept { return _points; }
+
+    // Для Clipper: точки контура добавляются по одной, close_ring
+    // отбрасывает вырожденный контур (меньше трёх точек)
+    void push_point(const Point<double>& p) { _points.push_back(p); }
+
+    void close_ring() {
+        if (_points.size() - _rings.back() < 3) _points.resize(_rings.back());
+        else _rings.push_back(_points.size());
+    }
+
+    void close_group() { _groups.push_back(size()); }
+
+private:
+    double rings_area(size_t first, size_t last) const {
+        double total = 0;
+        for (size_t r = first; r < last; ++r) total += signed_area(r);
+        return total;
+    }
+
+    std::vector<Point<double>> _points;
+    std::vector<size_t> _rings;
+    std::vector<size_t> _groups;
+};
+
+// Движок отсечения. Держит рабочие буферы между вызовами, так что после
+// первых вызовов память больше не выделяется. Один Clipper - на один поток
+class Clipper {
+public:
+    // Результат дописывается в out отдельной группой
+    template<class T, class U>
+    void clip(ClipOp op, const PolygonSpan<T>& a, const PolygonSpan<U>& b, ClipResult& out) {
+        load(a, _a);
+        load(b, _b);
+        if (_a.empty() || _b.empty()) {
+            // Пустая (вырожденная) фигура
+            if (op == ClipOp::Union) emit(_a.empty() ? _b : _a, out);
+            else if (op == ClipOp::Difference && _b.empty()) emit(_a, out);
+        } else if (op == ClipOp::Intersection && is_convex(_a) && is_convex(_b)) {
+            sutherland_hodgman(out);
+        } else {
+            overlay(op, out);
+        }
+        out.close_group();
+    }
+
+    template<class T, class U>
+    void clip(ClipOp op, const Figure<T>& a, const Figure<U>& b, ClipResult& out) {
+        clip(op, PolygonSpan<T>(a.vertices()), PolygonSpan<U>(b.vertices()), out);
+    }
+
+    // Пересечение subject с выпуклой фигурой clip (Сазерленд-Ходжмен)
+    template<class T, class U>
+    void clip_convex(const PolygonSpan<T>& subject, const PolygonSpan<U>& clip, ClipResult& out) {
+        load(subject, _a);
+        load(clip, _b);
+        if (!_b.empty() && !is_convex(_b)) throw std::invalid_argument("Clip polygon is not convex");
+        if (!_a.empty() && !_b.empty()) sutherland_hodgman(out);
+        out.close_group();
+    }
+
+    // Площадь результата без сохранения контуров
+    template<class T, class U>
+    double area(ClipOp op, const Figure<T>& a, const Figure<U>& b) {
+        _result.clear();
+        clip(op, a, b, _result);
+        return _result.area();
+    }
+
+    // Пакет пар фигур: для pairs[k] = (i, j) в out добавляется группа k
+    // с результатом операции над figures[i] и figures[j]
+    template<class T>
+    void clip_pairs(ClipOp op, const Array<std::shared_ptr<Figure<T>>>& figures,
+                    std::span<const std::pair<size_t, size_t>> pairs, ClipResult& out) {
+        for (const auto& [i, j] : pairs) clip(op, *figures[i], *figures[j], out);
+    }
+
+private:
+    using P = Point<double>;
+
+    struct Split {
+        size_t edge;
+        double t;
+        P p;
+    };
+
+    struct Edge {
+        P p;
+        P q;
+    };
+
+    static bool same(const P& a, const P& b) { return a.getX() == b.getX() && a.getY() == b.getY(); }
+
+    static double cross(const P& o, const P& a, const P& b) {
+        return (a.getX() - o.getX()) * (b.getY() - o.getY()) - (a.getY() - o.getY()) * (b.getX() - o.getX());
+    }
+
+    static bool less(const P& a, const P& b) {
+        return a.getX() < b.getX() || (a.getX() == b.getX() && a.getY() < b.getY());
+    }
+
+    static bool edge_less(const Edge& a, const Edge& b) {
+        if (!same(a.p, b.p)) return less(a.p, b.p);
+        return less(a.q, b.q);
+    }
+
+    // Убираем повторы и точки на одной прямой с соседями
+    static void clean_ring(std::vector<P>& ring) {
+        size_t n = 0;
+        for (size_t i = 0; i < ring.size(); ++i) {
+            const P p = ring[i];
+            if (n > 0 && same(ring[n - 1], p)) continue;
+            while (n >= 2 && cross(ring[n - 2], ring[n - 1], p) == 0) --n;
+            ring[n++] = p;
+        }
+        ring.resize(n);
+        while (ring.size() >= 3 && (same(ring.back(), ring.front()) || cross(ring[ring.size() - 2], ring.back(), ring.front()) == 0)) {
+            ring.pop_back();
+        }
+        while (ring.size() >= 3 && cross(ring.back(), ring[0], ring[1]) == 0) ring.erase(ring.begin());
+        if (ring.size() < 3) ring.clear();
+    }
+
+    // Вершины в double, без вырожденных точек, против часовой стрелки.
+    // Фигура нулевой площади становится пустой
+    template<class T>
+    static void load(const PolygonSpan<T>& span, std::vector<P>& ring) {
+        ring.clear();
+        for (size_t i = 0; i < span.size(); ++i) {
+            const auto p = span.point(i);
+            ring.emplace_back(static_cast<double>(p.getX()), static_cast<double>(p.getY()));
+        }
+        clean_ring(ring);
+        double twice = 0;
+        for (size_t i = 0; i < ring.size(); ++i) twice += cross(P(), ring[i], ring[(i + 1) % ring.size()]);
+        if (twice == 0) ring.clear();
+        else if (twice < 0) std::reverse(ring.begin(), ring.end());
+    }
+
+    static bool is_convex(const std::vector<P>& ring) {
+        const size_t n = ring.size();
+        for (size_t i = 0; i < n; ++i) {
+            if (cross(ring[i], ring[(i + 1) % n], ring[(i + 2) % n]) < 0) return false;
+        }
+        return true;
+    }
+
+    static void emit(const std::vector<P>& ring, ClipResult& out) {
+        for (const P& p : ring) out.push_point(p);
+        out.close_ring();
+    }
+
+    // Пересечение _a с выпуклой _b
+    void sutherland_hodgman(ClipResult& out) {
+        _ring = _a;
+        for (size_t j = 0; j < _b.size() && !_ring.empty(); ++j) {
+            const P& c0 = _b[j];
+            const P& c1 = _b[(j + 1) % _b.size()];
+            _next.clear();
+            for (size_t i = 0; i < _ring.size(); ++i) {
+                const P& s = _ring[i];
+                const P& e = _ring[(i + 1) % _ring.size()];
+                const double ds = cross(c0, c1, s);
+                const double de = cross(c0, c1, e);
+                if (de >= 0) {
+                    if (ds < 0) _next.push_back(line_point(s, e, ds, de));
+                    _next.push_back(e);
+                } else if (ds >= 0) {
+                    if (ds > 0) _next.push_back(line_point(s, e, ds, de));
+                }
+            }
+            std::swap(_ring, _next);
+            clean_ring(_ring);
+        }
+        emit(_ring, out);
+    }
+
+    // Точка отрезка s-e на прямой, где знаковое расстояние меняется с ds на de
+    static P line_point(const P& s, const P& e, double ds, double de) {
+        const double t = ds / (ds - de);
+        return P(s.getX() + t * (e.getX() - s.getX()), s.getY() + t * (e.getY() - s.getY()));
+    }
+
+    // Разрезание рёбер _a и _b во всех точках их пересечения
+    void find_splits() {
+        _splits_a.clear();
+        _splits_b.clear();
+        const size_t n = _a.size(), m = _b.size();
+        for (size_t i = 0; i < n; ++i) {
+            const P& a0 = _a[i];
+            const P& a1 = _a[(i + 1) % n];
+            const double rx = a1.getX() - a0.getX(), ry = a1.getY() - a0.getY();
+            for (size_t j = 0; j < m; ++j) {
+                const P& b0 = _b[j];
+                const P& b1 = _b[(j + 1) % m];
+                const double sx = b1.getX() - b0.getX(), sy = b1.getY() - b0.getY();
+                const double qx = b0.getX() - a0.getX(), qy = b0.getY() - a0.getY();
+                double d = rx * sy - ry * sx;
+                double tn = qx * sy - qy * sx;
+                double un = qx * ry - qy * rx;
+                if (d == 0) {
+                    if (un != 0) continue; // параллельны
+                    // На одной прямой: режем по концам другого ребра
+                    const double rr = rx * rx + ry * ry, ss = sx * sx + sy * sy;
+                    for (const P& b : {b0, b1}) {
+                        const double t = ((b.getX() - a0.getX()) * rx + (b.getY() - a0.getY()) * ry) / rr;
+                        if (t > 0 && t < 1) _splits_a.push_back({i, t, b});
+                    }
+                    for (const P& a : {a0, a1}) {
+                        const double u = ((a.getX() - b0.getX()) * sx + (a.getY() - b0.getY()) * sy) / ss;
+                        if (u > 0 && u < 1) _splits_b.push_back({j, u, a});
+                    }
+                    continue;
+                }
+                if (d < 0) {
+                    d = -d;
+                    tn = -tn;
+                    un = -un;
+                }
+                if (tn < 0 || tn > d || un < 0 || un > d) continue;
+                // Если точка совпадает с вершиной, берём саму вершину
+                P p;
+                if (tn == 0) p = a0;
+                else if (tn == d) p = a1;
+                else if (un == 0) p = b0;
+                else if (un == d) p = b1;
+                else p = P(a0.getX() + rx * (tn / d), a0.getY() + ry * (tn / d));
+                if (tn > 0 && tn < d) _splits_a.push_back({i, tn / d, p});
+                if (un > 0 && un < d) _splits_b.push_back({j, un / d, p});
+            }
+        }
+    }
+
+    // Вершины фигуры вместе с точками разреза
+    static void apply_splits(const std::vector<P>& ring, std::vector<Split>& splits, std::vector<P>& out) {
+        std::sort(splits.begin(), splits.end(), [](const Split& x, const Split& y) {
+            return x.edge < y.edge || (x.edge == y.edge && x.t < y.t);
+        });
+        out.clear();
+        auto push = [&](const P& p) {
+            if (out.empty() || !same(out.back(), p)) out.push_back(p);
+        };
+        size_t k = 0;
+        for (size_t i = 0; i < ring.size(); ++i) {
+            push(ring[i]);
+            for (; k < splits.size() && splits[k].edge == i; ++k) push(splits[k].p);
+        }
+        while (out.size() > 1 && same(out.back(), out.front())) out.pop_back();
+    }
+
+    // Строго внутри (точки на границе сюда не попадают: после разрезания
+    // середина куска ребра не лежит на границе другой фигуры)
+    static bool inside(const std::vector<P>& ring, const P& m) {
+        bool c = false;
+        for (size_t i = 0, n = ring.size(); i < n; ++i) {
+            const P& p = ring[i];
+            const P& q = ring[(i + 1) % n];
+            if ((p.getY() > m.getY()) != (q.getY() > m.getY())) {
+                const double x = p.getX() + (m.getY() - p.getY()) * (q.getX() - p.getX()) / (q.getY() - p.getY());
+                if (m.getX() < x) c = !c;
+            }
+        }
+        return c;
+    }
+
+    static P midpoint(const P& p, const P& q) {
+        return P((p.getX() + q.getX()) * 0.5, (p.getY() + q.getY()) * 0.5);
+    }
+
+    bool has_b_edge(const P& p, const P& q) const {
+        const Edge key{p, q};
+        return std::binary_search(_b_edges.begin(), _b_edges.end(), key, edge_less);
+    }
+
+    void overlay(ClipOp op, ClipResult& out) {
+        find_splits();
+        apply_splits(_a, _splits_a, _va);
+        apply_splits(_b, _splits_b, _vb);
+
+        _b_edges.clear();
+        for (size_t j = 0; j < _vb.size(); ++j) _b_edges.push_back({_vb[j], _vb[(j + 1) % _vb.size()]});
+        std::sort(_b_edges.begin(), _b_edges.end(), edge_less);
+
+        // Выбор кусков рёбер. Общие рёбра берутся только из A
+        _edges.clear();
+        for (size_t i = 0; i < _va.size(); ++i) {
+            const P& p = _va[i];
+            const P& q = _va[(i + 1) % _va.size()];
+            bool take;
+            if (has_b_edge(p, q)) take = op != ClipOp::Difference;
+            else if (has_b_edge(q, p)) take = op == ClipOp::Difference;
+            else take = inside(_b, midpoint(p, q)) == (op == ClipOp::Intersection);
+            if (take) _edges.push_back({p, q});
+        }
+        _a_edges.clear();
+        for (size_t i = 0; i < _va.size(); ++i) _a_edges.push_back({_va[i], _va[(i + 1) % _va.size()]});
+        std::sort(_a_edges.begin(), _a_edges.end(), edge_less);
+        for (size_t j = 0; j < _vb.size(); ++j) {
+            const P& p = _vb[j];
+            const P& q = _vb[(j + 1) % _vb.size()];
+            const Edge same_dir{p, q}, opposite{q, p};
+            if (std::binary_search(_a_edges.begin(), _a_edges.end(), same_dir, edge_less) ||
+                std::binary_search(_a_edges.begin(), _a_edges.end(), opposite, edge_less)) {
+                continue;
+            }
+            const bool in_a = inside(_a, midpoint(p, q));
+            if (op == ClipOp::Intersection && in_a) _edges.push_back({p, q});
+            else if (op == ClipOp::Union && !in_a) _edges.push_back({p, q});
+            else if (op == ClipOp::Difference && in_a) _edges.push_back({q, p});
+        }
+        link(out);
+    }
+
+    // Сшивание выбранных рёбер в замкнутые контуры
+    void link(ClipResult& out) {
+        std::sort(_edges.begin(), _edges.end(), edge_less);
+        _used.assign(_edges.size(), 0);
+        for (size_t s = 0; s < _edges.size(); ++s) {
+            if (_used[s]) continue;
+            _ring.clear();
+            size_t e = s;
+            bool closed = false;
+            while (true) {
+                _used[e] = 1;
+                _ring.push_back(_edges[e].p);
+                const P& end = _edges[e].q;
+                if (same(end, _edges[s].p)) {
+                    closed = true;
+                    break;
+                }
+                auto it = std::lower_bound(_edges.begin(), _edges.end(), end,
+                                           [](const Edge& x, const P& p) { return less(x.p, p); });
+                size_t next = _edges.size();
+                for (; it != _edges.end() && same(it->p, end); ++it) {
+                    const size_t idx = static_cast<size_t>(it - _edges.begin());
+                    if (!_used[idx]) {
+                        next = idx;
+                        break;
+                    }
+                }
+                if (next == _edges.size()) break;
+                e = next;
+            }
+            if (!closed) continue;
+            clean_ring(_ring);
+            emit(_ring, out);
+        }
+    }
+
+    std::vector<P> _a, _b, _va, _vb, _ring, _next;
+    std::vector<Split> _splits_a, _splits_b;
+    std::vector<Edge> _edges, _a_edges, _b_edges;
+    std::vector<uint8_t> _used;
+    ClipResult _result;
+};
+
+// Контур результата как самостоятельная фигура
+inline Polygon<double> make_polygon(const PolygonSpan<double>& ring,
+                                    std::pmr::memory_resource* resource = std::pmr::get_default_resource()) {
+    Polygon<double> polygon(resource);
+    polygon.add_points(ring);
+    return polygon;
+}
@@ -0,0 +1,295 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include "simd_area.h"
+#include "store.h"
+
+// Сжатое хранилище фигур. Вершины фигуры хранятся как первая точка и
+// разности соседних точек (zig-zag, чтобы маленькие отрицательные числа тоже
+// были короткими) в одном из двух видов:
+// - Varint: каждая разность - LEB128, 1 байт для |d| < 64;
+// - FixedWidth: у фигуры одна ширина w бит на все разности, поля идут подряд;
+//   распаковка без ветвлений, одна невыровненная загрузка на поле.
+// Координаты с плавающей точкой сначала округляются до сетки с шагом grid,
+// целые хранятся без потерь (grid == 0) или тоже по сетке.
+// Для площадей фигуры распаковываются блоками в FigureStore, и дальше
+// работают векторные ядра из simd_area.h
+
+enum class VertexEncoding : uint8_t {
+    Varint,
+    FixedWidth,
+};
+
+#ifndef __SIZEOF_INT128__
+#error "CompressedFigureStore needs a compiler with __int128 (GCC or Clang on a 64-bit target)"
+#endif
+
+namespace compressed_detail {
+
+__extension__ typedef unsigned __int128 uint128_t;
+
+// Сколько нулевых байт держим в конце буфера, чтобы 16-байтная загрузка
+// последнего поля не выходила за его границу
+inline constexpr size_t kPadding = 16;
+
+// Больше этого одна фигура не занимает: 10 varint-ов точки, байт ширины
+// и 8 разностей по 10 байт
+inline constexpr size_t kMaxFigureBytes = 128;
+
+inline uint64_t zigzag(int64_t v) noexcept {
+    return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+}
+
+inline int64_t unzigzag(uint64_t v) noexcept {
+    return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+}
+
+inline void put_varint(std::vector<uint8_t>& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<uint8_t>(v) | 0x80);
+        v >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+inline uint64_t get_varint(const uint8_t*& p) noexcept {
+    uint64_t v = 0;
+    for (unsigned shift = 0;; shift += 7) {
+        const uint8_t byte = *p++;
+        v |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return v;
+    }
+}
+
+// Поле шириной width (0..64) бит, начиная с бита bit
+inline uint64_t get_field(const uint8_t* bytes, size_t bit, unsigned width) noexcept {
+    uint128_t word;
+    std::memcpy(&word, bytes + bit / 8, sizeof(word));
+    const uint128_t mask = (uint128_t(1) << width) - 1;
+    return static_cast<uint64_t>((word >> (bit % 8)) & mask);
+}
+
+// Разность по модулю 2^64: обратима при любых координатах
+inline int64_t delta(int64_t to, int64_t from) noexcept {
+    return static_cast<int64_t>(static_cast<uint64_t>(to) - static_cast<uint64_t>(from));
+}
+
+inline int64_t advance(int64_t from, int64_t d) noexcept {
+    return static_cast<int64_t>(static_cast<uint64_t>(from) + static_cast<uint64_t>(d));
+}
+
+} // namespace compressed_detail
+
+template<Pointable T>
+class CompressedFigureStore {
+public:
+    // Сколько фигур распаковывается за раз при пакетных вычислениях
+    static constexpr size_t kDecodeBlock = 1024;
+
+    // grid - шаг сетки квантования; 0 - без потерь, только для целых координат
+    explicit CompressedFigureStore(VertexEncoding encoding = VertexEncoding::Varint, double grid = 0)
+        : _encoding(encoding), _grid(grid) {
+        if (!(grid >= 0) || !std::isfinite(grid)) throw std::invalid_argument("Invalid quantization grid");
+        if (!std::is_integral_v<T> && grid == 0) {
+            throw std::invalid_argument("Floating coordinates need a quantization grid");
+        }
+        _offsets.push_back(0);
+        _bytes.resize(compressed_detail::kPadding);
+    }
+
+    static CompressedFigureStore from(const FigureStore<T>& store, VertexEncoding encoding = VertexEncoding::Varint,
+                                      double grid = 0) {
+        CompressedFigureStore result(encoding, grid);
+        result.append(store);
+        return result;
+    }
+
+    template<class Range>
+    void push_back(FigureKind kind, const Range& points) {
+        const size_t n = static_cast<size_t>(std::distance(std::begin(points), std::end(points)));
+        if (n != figure_arity(kind)) throw std::invalid_argument("Wrong number of points for figure");
+        std::array<int64_t, 5> qx, qy;
+        size_t i = 0;
+        for (const auto& p : points) {
+            qx[i] = quantize(p.getX());
+            qy[i] = quantize(p.getY());
+            ++i;
+        }
+        encode(kind, n, qx.data(), qy.data());
+    }
+
+    // Добавление из Rhombus/Trapezoid/Pentagon
+    template<class F>
+        requires requires { F::kind; }
+    void push_back(const F& figure) {
+        push_back(F::kind, figure.vertices());
+    }
+
+    void append(const FigureStore<T>& store) {
+        for (size_t i = 0; i < store.size(); ++i) {
+            const auto figure = store[i];
+            std::array<Point<T>, 5> points;
+            for (size_t j = 0; j < figure.size(); ++j) points[j] = Point<T>(figure.xs()[j], figure.ys()[j]);
+            push_back(figure.kind(), std::span<const Point<T>>(points.data(), figure.size()));
+        }
+    }
+
+    size_t size() const noexcept { return _kinds.size(); }
+    bool empty() const noexcept { return _kinds.empty(); }
+    VertexEncoding encoding() const noexcept { return _encoding; }
+    double grid() const noexcept { return _grid; }
+
+    // Занятая память: закодированные вершины, смещения и виды фигур
+    size_t byte_size() const noexcept {
+        return _bytes.size() - compressed_detail::kPadding + _offsets.size() * sizeof(uint32_t) +
+               _kinds.size() * sizeof(FigureKind);
+    }
+
+    FigureKind kind(size_t idx) const {
+        if (idx >= size()) throw std::out_of_range("CompressedFigureStore index out of range");
+        return _kinds[idx];
+    }
+
+    // Вершины фигуры idx в out (не меньше figure_arity); возвращает их число
+    size_t decode(size_t idx, std::span<Point<T>> out) const {
+        const size_t n = figure_arity(kind(idx));
+        if (out.size() < n) throw std::invalid_argument("Output span is too small");
+        std::array<int64_t, 5> qx, qy;
+        decode_grid(idx, n, qx.data(), qy.data());
+        for (size_t j = 0; j < n; ++j) out[j] = Point<T>(dequantize(qx[j]), dequantize(qy[j]));
+        return n;
+    }
+
+    // Распаковка count фигур начиная с first в конец обычного хранилища
+    void decode_into(FigureStore<T>& out, size_t first, size_t count) const {
+        if (first > size() || count > size() - first) throw std::out_of_range("CompressedFigureStore range out of range");
+        for (size_t i = first; i < first + count; ++i) {
+            std::array<Point<T>, 5> points;
+            const size_t n = decode(i, points);
+            out.push_back(_kinds[i], std::span<const Point<T>>(points.data(), n));
+        }
+    }
+
+    FigureStore<T> decode_all() const {
+        FigureStore<T> out;
+        out.reserve(size(), size() * 5);
+        decode_into(out, 0, size());
+        return out;
+    }
+
+    double area(size_t idx) const {
+        std::array<Point<T>, 5> points;
+        const size_t n = decode(idx, points);
+        return shoelace_area(n, [&](size_t j) { return points[j]; });
+    }
+
+    Point<T> center(size_t idx) const {
+        std::array<Point<T>, 5> points;
+        const size_t n = decode(idx, points);
+        return figure_center<T>(_kinds[idx], n, [&](size_t j) { return points[j]; });
+    }
+
+    // Площади всех фигур: распаковка блоками по kDecodeBlock и векторное ядро
+    void areas(std::span<double> out, SimdLevel level = detect_simd_level()) const {
+        if (out.size() < size()) throw std::invalid_argument("Output span is too small");
+        FigureStore<T> block;
+        block.reserve(kDecodeBlock, kDecodeBlock * 5);
+        for (size_t first = 0; first < size(); first += kDecodeBlock) {
+            const size_t count = std::min(kDecodeBlock, size() - first);
+            block.clear();
+            decode_into(block, first, count);
+            ::areas(block, out.subspan(first, count), level);
+        }
+    }
+
+    double total_area(SimdLevel level = detect_simd_level()) const {
+        std::vector<double> values(size());
+        areas(values, level);
+        double total = 0;
+        for (double v : values) total += v;
+        return total;
+    }
+
+private:
+    int64_t quantize(T value) const {
+        if (_grid == 0) return static_cast<int64_t>(value);
+        const double scaled = std::round(static_cast<double>(value) / _grid);
+        // Запас в два бита, чтобы разности не теряли знак при zig-zag
+        if (!(std::abs(scaled) < 0x1p62)) throw std::out_of_range("Coordinate does not fit the quantization grid");
+        return static_cast<int64_t>(scaled);
+    }
+
+    T dequantize(int64_t q) const {
+        if (_grid == 0) return static_cast<T>(q);
+        if constexpr (std::is_integral_v<T>) return static_cast<T>(std::llround(static_cast<double>(q) * _grid));
+        else return static_cast<T>(static_cast<double>(q) * _grid);
+    }
+
+    void encode(FigureKind kind, size_t n, const int64_t* qx, const int64_t* qy) {
+        using namespace compressed_detail;
+        // Смещения 32-битные: 4 ГБ сжатых данных хватает на сотни миллионов фигур
+        if (_bytes.size() + kMaxFigureBytes > UINT32_MAX) throw std::length_error("CompressedFigureStore is too large");
+        _bytes.resize(_bytes.size() - kPadding);
+        put_varint(_bytes, zigzag(qx[0]));
+        put_varint(_bytes, zigzag(qy[0]));
+        std::array<uint64_t, 8> fields;
+        uint64_t all = 0;
+        for (size_t j = 1; j < n; ++j) {
+            fields[2 * (j - 1)] = zigzag(delta(qx[j], qx[j - 1]));
+            fields[2 * (j - 1) + 1] = zigzag(delta(qy[j], qy[j - 1]));
+            all |= fields[2 * (j - 1)] | fields[2 * (j - 1) + 1];
+        }
+        const size_t count = 2 * (n - 1);
+        if (_encoding == VertexEncoding::Varint) {
+            for (size_t k = 0; k < count; ++k) put_varint(_bytes, fields[k]);
+        } else {
+            const unsigned width = static_cast<unsigned>(std::bit_width(all));
+            _bytes.push_back(static_cast<uint8_t>(width));
+            const size_t start = _bytes.size();
+            _bytes.resize(start + (count * width + 7) / 8);
+            for (size_t k = 0, bit = 0; k < count; ++k, bit += width) {
+                for (unsigned b = 0; b < width; ++b) {
+                    if (fields[k] >> b & 1) _bytes[start + (bit + b) / 8] |= static_cast<uint8_t>(1u << ((bit + b) % 8));
+                }
+            }
+        }
+        _bytes.resize(_bytes.size() + kPadding);
+        _kinds.push_back(kind);
+        _offsets.push_back(static_cast<uint32_t>(_bytes.size() - kPadding));
+    }
+
+    // Координаты вершин на сетке
+    void decode_grid(size_t idx, size_t n, int64_t* qx, int64_t* qy) const {
+        using namespace compressed_detail;
+        const uint8_t* p = _bytes.data() + _offsets[idx];
+        qx[0] = unzigzag(get_varint(p));
+        qy[0] = unzigzag(get_varint(p));
+        std::array<uint64_t, 8> fields;
+        const size_t count = 2 * (n - 1);
+        if (_encoding == VertexEncoding::Varint) {
+            for (size_t k = 0; k < count; ++k) fields[k] = get_varint(p);
+        } else {
+            const unsigned width = *p++;
+            for (size_t k = 0; k < count; ++k) fields[k] = get_field(p, k * width, width);
+        }
+        for (size_t j = 1; j < n; ++j) {
+            qx[j] = advance(qx[j - 1], unzigzag(fields[2 * (j - 1)]));
+            qy[j] = advance(qy[j - 1], unzigzag(fields[2 * (j - 1) + 1]));
+        }
+    }
+
+    VertexEncoding _encoding;
+    double _grid;
+    std::vector<FigureKind> _kinds;
+    std::vector<uint32_t> _offsets;
+    std::vector<uint8_t> _bytes;
+};
@@ -0,0 +1,256 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include "array.h"
+#include "base.h"
+#include "spatial_index.h"
+
+// Проверка "точка внутри фигуры" для пакетов точек.
+// Рёбра многоугольника заранее раскладываются в плоские массивы, а точки
+// обрабатываются блоками: внешний цикл по рёбрам, внутренний - по точкам
+// блока без ветвлений.
+// Используется правило чётности пересечений (crossing number), точки на
+// границе считаются внутренними. Ответ для целых координат точный:
+// - 8- и 16-битные считаются в int64, цикл векторизуется;
+// - 32-битные считаются в double с оценкой погрешности (фильтр), цикл
+//   векторизуется, а пары точка-ребро, где знак не гарантирован, после
+//   цикла пересчитываются в int128;
+// - 64-битные считаются в int128 без векторизации и должны лежать в
+//   [-2^62, 2^62]: тогда векторное произведение разностей помещается в 128 бит.
+// Вещественные координаты считаются в double
+
+namespace containment_detail {
+
+using geometry_detail::int128_t;
+
+// Тип, в котором считаются векторные произведения без переполнения
+template<class T>
+struct wide {
+    using type = double;
+};
+
+// Разности 16-битных координат - 17 бит, произведение - 34 бита
+template<class T>
+    requires std::is_integral_v<T> && (sizeof(T) <= 2)
+struct wide<T> {
+    using type = int64_t;
+};
+
+// 32-битные координаты и их разности представимы в double точно,
+// погрешность есть только у произведений, см. kOrientError
+template<class T>
+    requires std::is_integral_v<T> && (sizeof(T) == 4)
+struct wide<T> {
+    using type = double;
+};
+
+template<class T>
+    requires std::is_integral_v<T> && (sizeof(T) > 4)
+struct wide<T> {
+    using type = int128_t;
+};
+
+// Считаем ли в double с точным пересчётом сомнительных случаев
+template<class T>
+inline constexpr bool filtered = std::is_integral_v<T> && sizeof(T) == 4;
+
+// Оценка ошибки a - b в double при точных множителях (Shewchuk,
+// ccwerrboundA): если |a - b| > kOrientError * (|a| + |b|), знак верный
+inline constexpr double kOrientError = (3.0 + 16.0 * 0x1p-53) * 0x1p-53;
+
+// Предел для 64-битных координат, см. выше
+inline constexpr int64_t kMaxWideCoord = int64_t(1) << 62;
+
+template<class W, class T>
+W widen(T v) {
+    if constexpr (std::is_integral_v<T> && sizeof(T) > 4) {
+        if (static_cast<int128_t>(v) > kMaxWideCoord || static_cast<int128_t>(v) < -kMaxWideCoord) {
+            throw std::out_of_range("Coordinate is too large for exact containment test");
+        }
+    }
+    return static_cast<W>(v);
+}
+
+} // namespace containment_detail
+
+template<class T>
+using containment_wide_t = typename containment_detail::wide<T>::type;
+
+// Сколько точек обрабатывается за один проход по рёбрам
+inline constexpr size_t kContainmentBlock = 64;
+
+template<class T>
+class PolygonEdges {
+public:
+    using W = containment_wide_t<T>;
+
+    template<class At>
+    PolygonEdges(size_t n, At&& at) {
+        if (n < 3) throw std::invalid_argument("Polygon needs at least 3 points");
+        _x0.reserve(n); _y0.reserve(n); _dx.reserve(n); _dy.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            const auto& p = at(i);
+            const auto& q = at((i + 1) % n);
+            using containment_detail::widen;
+            const W x0 = widen<W>(p.getX()), y0 = widen<W>(p.getY());
+            _x0.push_back(x0);
+            _y0.push_back(y0);
+            _dx.push_back(widen<W>(q.getX()) - x0);
+            _dy.push_back(widen<W>(q.getY()) - y0);
+        }
+    }
+
+    explicit PolygonEdges(const Figure<T>& figure)
+        : PolygonEdges(figure.get_points_count(), [&](size_t i) -> const Point<T>& { return figure.get_point(i); }) {}
+
+    size_t size() const noexcept { return _x0.size(); }
+
+    bool contains(const Point<T>& p) const {
+        uint8_t result;
+        contains(std::span<const Point<T>>(&p, 1), std::span<uint8_t>(&result, 1));
+        return result != 0;
+    }
+
+    // out[i] = 1, если queries[i] внутри или на границе
+    void contains(std::span<const Point<T>> queries, std::span<uint8_t> out) const {
+        if (out.size() != queries.size()) throw std::invalid_argument("Output size does not match queries");
+        W qx[kContainmentBlock], qy[kContainmentBlock];
+        uint8_t inside[kContainmentBlock], boundary[kContainmentBlock], unsure[kContainmentBlock];
+        for (size_t first = 0; first < queries.size(); first += kContainmentBlock) {
+            const size_t m = std::min(kContainmentBlock, queries.size() - first);
+            for (size_t j = 0; j < m; ++j) {
+                qx[j] = containment_detail::widen<W>(queries[first + j].getX());
+                qy[j] = containment_detail::widen<W>(queries[first + j].getY());
+                inside[j] = 0;
+                boundary[j] = 0;
+            }
+            for (size_t e = 0; e < _x0.size(); ++e) {
+                if constexpr (containment_detail::filtered<T>) {
+                    if (filtered_kernel(e, qx, qy, inside, unsure, m)) exact_fixup(e, qx, qy, inside, boundary, unsure, m);
+                } else {
+                    edge_kernel(e, qx, qy, inside, boundary, m);
+                }
+            }
+            for (size_t j = 0; j < m; ++j) out[first + j] = inside[j] | boundary[j];
+        }
+    }
+
+private:
+    void edge_kernel(size_t e, const W* qx, const W* qy, uint8_t* inside, uint8_t* boundary, size_t m) const {
+        const W x0 = _x0[e], y0 = _y0[e], dx = _dx[e], dy = _dy[e];
+        const W y1 = y0 + dy;
+        const W min_x = dx < 0 ? x0 + dx : x0, max_x = dx < 0 ? x0 : x0 + dx;
+        const W min_y = dy < 0 ? y1 : y0, max_y = dy < 0 ? y0 : y1;
+        const bool upward = dy > 0;
+        for (size_t j = 0; j < m; ++j) {
+            // Положение точки относительно ребра: > 0 - слева
+            const W orient = dx * (qy[j] - y0) - (qx[j] - x0) * dy;
+            // Полуоткрытое правило по y: общая вершина двух рёбер
+            // засчитывается ровно один раз
+            const bool spans = (y0 > qy[j]) != (y1 > qy[j]);
+            const bool crosses = spans & ((orient > 0) == upward) & (orient != 0);
+            const bool on_edge = (orient == 0) & (qx[j] >= min_x) & (qx[j] <= max_x) &
+                                 (qy[j] >= min_y) & (qy[j] <= max_y);
+            inside[j] ^= static_cast<uint8_t>(crosses);
+            boundary[j] |= static_cast<uint8_t>(on_edge);
+        }
+    }
+
+    // То же в double: пары, где знак orient не гарантирован, не трогаем, а
+    // отмечаем в unsure. Возвращает, есть ли такие пары
+    bool filtered_kernel(size_t e, const W* qx, const W* qy, uint8_t* inside, uint8_t* unsure, size_t m) const {
+        const W x0 = _x0[e], y0 = _y0[e], dx = _dx[e], dy = _dy[e];
+        const W y1 = y0 + dy;
+        const bool upward = dy > 0;
+        uint8_t any = 0;
+        for (size_t j = 0; j < m; ++j) {
+            const W a = dx * (qy[j] - y0), b = (qx[j] - x0) * dy;
+            const W orient = a - b;
+            const bool sure = std::abs(orient) > containment_detail::kOrientError * (std::abs(a) + std::abs(b));
+            const bool spans = (y0 > qy[j]) != (y1 > qy[j]);
+            inside[j] ^= static_cast<uint8_t>(spans & sure & ((orient > 0) == upward));
+            unsure[j] = static_cast<uint8_t>(!sure);
+            any |= unsure[j];
+        }
+        return any != 0;
+    }
+
+    // Точный пересчёт отмеченных пар в int128. Координаты в double здесь
+    // целые, так что переводятся без потерь
+    void exact_fixup(size_t e, const W* qx, const W* qy, uint8_t* inside, uint8_t* boundary, const uint8_t* unsure,
+                     size_t m) const {
+        using E = containment_detail::int128_t;
+        const E x0 = static_cast<E>(_x0[e]), y0 = static_cast<E>(_y0[e]);
+        const E dx = static_cast<E>(_dx[e]), dy = static_cast<E>(_dy[e]);
+        const E y1 = y0 + dy;
+        const E min_x = dx < 0 ? x0 + dx : x0, max_x = dx < 0 ? x0 : x0 + dx;
+        const E min_y = dy < 0 ? y1 : y0, max_y = dy < 0 ? y0 : y1;
+        for (size_t j = 0; j < m; ++j) {
+            if (!unsure[j]) continue;
+            const E px = static_cast<E>(qx[j]), py = static_cast<E>(qy[j]);
+            const E orient = dx * (py - y0) - (px - x0) * dy;
+            const bool spans = (y0 > py) != (y1 > py);
+            if (spans && orient != 0 && (orient > 0) == (dy > 0)) inside[j] ^= 1;
+            if (orient == 0 && px >= min_x && px <= max_x && py >= min_y && py <= max_y) boundary[j] = 1;
+        }
+    }
+
+    std::vector<W> _x0, _y0, _dx, _dy;
+};
+
+// Разовая проверка пакета точек против одной фигуры
+template<class T>
+void contains(const Figure<T>& figure, std::span<const Point<T>> queries, std::span<uint8_t> out) {
+    PolygonEdges<T>(figure).contains(queries, out);
+}
+
+// Набор фигур для поиска, в какой фигуре лежит точка. Кандидаты берутся из
+// R-дерева по габаритам, точная проверка - по подготовленным рёбрам
+template<class T>
+class PolygonSet {
+public:
+    static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+    explicit PolygonSet(const Array<std::shared_ptr<Figure<T>>>& figures) : _tree(figures) {
+        _edges.reserve(figures.size());
+        for (size_t i = 0; i < figures.size(); ++i) _edges.emplace_back(*figures[i]);
+    }
+
+    size_t size() const noexcept { return _edges.size(); }
+    const PolygonEdges<T>& edges(size_t idx) const { return _edges.at(idx); }
+
+    // out[i] - номер фигуры с наименьшим индексом, содержащей queries[i],
+    // или npos, если таких нет
+    void locate(std::span<const Point<T>> queries, std::span<size_t> out) const {
+        if (out.size() != queries.size()) throw std::invalid_argument("Output size does not match queries");
+        for (size_t i = 0; i < queries.size(); ++i) {
+            size_t best = npos;
+            for (size_t id : _tree.candidates(queries[i])) {
+                if (id < best && _edges[id].contains(queries[i])) best = id;
+            }
+            out[i] = best;
+        }
+    }
+
+    // Для каждой фигуры - сколько точек из queries в ней лежит
+    std::vector<size_t> count_inside(std::span<const Point<T>> queries) const {
+        std::vector<size_t> counts(_edges.size(), 0);
+        std::vector<uint8_t> flags(queries.size());
+        for (size_t f = 0; f < _edges.size(); ++f) {
+            _edges[f].contains(queries, flags);
+            for (uint8_t v : flags) counts[f] += v;
+        }
+        return counts;
+    }
+
+private:
+    RTree<T> _tree;
+    std::vector<PolygonEdges<T>> _edges;
+};
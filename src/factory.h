@@ -0,0 +1,83 @@
+#pragma once
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <stdexcept>
+#include "arena.h"
+#include "array.h"
+#include "figures.h"
+#include "figure_view.h"
+
+// Массовое создание фигур без ввода-вывода. Точки фигуры копируются за один
+// раз, кэш площади считается один раз; 4-5 вершин помещаются во встроенный
+// буфер PointContainer, так что сама фигура память не выделяет
+
+// Фигура F из диапазона точек; число точек должно совпадать с числом вершин
+template<class F, class Range>
+    requires requires { F::kind; }
+F make_figure(const Range& points, std::pmr::memory_resource* resource = std::pmr::get_default_resource()) {
+    const auto n = static_cast<size_t>(std::distance(std::begin(points), std::end(points)));
+    if (n != figure_arity(F::kind)) throw std::invalid_argument("Wrong number of points for figure");
+    F figure(resource);
+    figure.add_points(points);
+    return figure;
+}
+
+// Фигура F из отдельных массивов координат
+template<class F, class T>
+    requires requires { F::kind; }
+F make_figure(std::span<const T> xs, std::span<const T> ys,
+              std::pmr::memory_resource* resource = std::pmr::get_default_resource()) {
+    return make_figure<F>(PolygonSpan<T>(xs, ys), resource);
+}
+
+namespace factory_detail {
+
+// Число фигур вида F в плоских массивах координат
+template<class F, class T>
+size_t figure_count(std::span<const T> xs, std::span<const T> ys) {
+    if (xs.size() != ys.size()) throw std::invalid_argument("Coordinate spans differ in size");
+    const size_t arity = figure_arity(F::kind);
+    if (xs.size() % arity != 0) throw std::invalid_argument("Coordinate count is not a multiple of figure arity");
+    return xs.size() / arity;
+}
+
+// Вершины i-й фигуры как диапазон для add_points, без копирования
+template<class F, class T>
+PolygonSpan<T> figure_at(std::span<const T> xs, std::span<const T> ys, size_t i) {
+    const size_t arity = figure_arity(F::kind);
+    return PolygonSpan<T>(xs.subspan(i * arity, arity), ys.subspan(i * arity, arity));
+}
+
+} // namespace factory_detail
+
+// Добавляет в out фигуры F, вершины которых идут подряд в xs/ys (по
+// figure_arity(F::kind) на фигуру). Массив расширяется один раз, фигуры
+// создаются прямо в нём через emplace_back
+template<class F, class T>
+    requires requires { F::kind; }
+void emplace_figures(Array<F>& out, std::span<const T> xs, std::span<const T> ys,
+                     std::pmr::memory_resource* resource = std::pmr::get_default_resource()) {
+    const size_t count = factory_detail::figure_count<F>(xs, ys);
+    out.reserve(out.size() + count);
+    for (size_t i = 0; i < count; ++i) {
+        out.emplace_back(resource).add_points(factory_detail::figure_at<F>(xs, ys, i));
+    }
+}
+
+// То же для массива указателей: одно выделение на фигуру (объект и счётчик
+// ссылок вместе) из resource, например из Arena
+template<class F, class T>
+    requires requires { F::kind; }
+void emplace_figures(Array<std::shared_ptr<Figure<T>>>& out, std::span<const T> xs, std::span<const T> ys,
+                     std::pmr::memory_resource& resource = *std::pmr::get_default_resource()) {
+    const size_t count = factory_detail::figure_count<F>(xs, ys);
+    out.reserve(out.size() + count);
+    for (size_t i = 0; i < count; ++i) {
+        auto figure = make_shared_in<F>(resource);
+        figure->add_points(factory_detail::figure_at<F>(xs, ys, i));
+        out.emplace_back(std::move(figure));
+    }
+}
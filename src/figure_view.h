@@ -0,0 +1,138 @@
+#pragma once
+#include <cstddef>
+#include <iostream>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include "figures.h"
+#include "geometry.h"
+#include "store.h"
+
+// Вершины многоугольника в чужой памяти: массив точек или два массива
+// координат (сетевой буфер, mmap-файл, FigureStore). Ничем не владеет и не
+// выделяет память; буфер должен жить дольше PolygonSpan
+template<Pointable T>
+class PolygonSpan {
+public:
+    PolygonSpan() = default;
+
+    PolygonSpan(std::span<const Point<T>> points) : _points(points.data()), _n(points.size()) {}
+
+    PolygonSpan(std::span<const T> xs, std::span<const T> ys) : _xs(xs.data()), _ys(ys.data()), _n(xs.size()) {
+        if (xs.size() != ys.size()) throw std::invalid_argument("Coordinate spans differ in size");
+    }
+
+    // Перебор вершин в range-for; точки отдаются по значению
+    class iterator {
+    public:
+        using value_type = Point<T>;
+        using difference_type = std::ptrdiff_t;
+        using iterator_category = std::input_iterator_tag;
+
+        iterator() = default;
+        iterator(const PolygonSpan* span, size_t i) : _span(span), _i(i) {}
+
+        Point<T> operator*() const { return _span->point(_i); }
+        iterator& operator++() { ++_i; return *this; }
+        iterator operator++(int) { iterator tmp = *this; ++_i; return tmp; }
+        bool operator==(const iterator& other) const { return _i == other._i; }
+
+    private:
+        const PolygonSpan* _span = nullptr;
+        size_t _i = 0;
+    };
+
+    iterator begin() const { return iterator(this, 0); }
+    iterator end() const { return iterator(this, _n); }
+
+    size_t size() const noexcept { return _n; }
+    bool empty() const noexcept { return _n == 0; }
+
+    Point<T> operator[](size_t i) const {
+        if (i >= _n) throw std::out_of_range("Index out of range");
+        return point(i);
+    }
+
+    // Без проверки индекса
+    Point<T> point(size_t i) const noexcept {
+        return _points ? _points[i] : Point<T>(_xs[i], _ys[i]);
+    }
+
+    template<class Policy = FastArithmetic>
+    double area() const {
+        return visit([this](auto at) { return shoelace_area<Policy>(_n, at); });
+    }
+
+    // Центр масс, габариты и ориентированная площадь за один проход
+    PolygonAccumulator<T> accumulate() const {
+        PolygonAccumulator<T> acc;
+        visit([&](auto at) {
+            for (size_t i = 0; i < _n; ++i) acc.add(at(i));
+            return 0;
+        });
+        return acc;
+    }
+
+    Point<double> centroid() const { return accumulate().centroid(); }
+    Bounds<T> bounds() const { return accumulate().bounds(); }
+
+    // Вызывает f(at) с функцией доступа к вершинам для нужного вида буфера,
+    // чтобы в цикле не проверять его каждый раз
+    template<class F>
+    decltype(auto) visit(F&& f) const {
+        if (_points) return f([p = _points](size_t i) -> const Point<T>& { return p[i]; });
+        return f([xs = _xs, ys = _ys](size_t i) { return Point<T>(xs[i], ys[i]); });
+    }
+
+private:
+    const Point<T>* _points = nullptr;
+    const T* _xs = nullptr;
+    const T* _ys = nullptr;
+    size_t _n = 0;
+};
+
+// Фигура заданного вида поверх PolygonSpan: те же площадь, центр и вывод,
+// что у Rhombus/Trapezoid/Pentagon, но без копирования вершин
+template<Pointable T>
+class FigureView {
+public:
+    FigureView(FigureKind kind, PolygonSpan<T> vertices) : _kind(kind), _vertices(vertices) {
+        if (vertices.size() != figure_arity(kind)) throw std::invalid_argument("Wrong number of points for figure");
+    }
+
+    FigureView(const StoredFigure<T>& figure)
+        : FigureView(figure.kind(), PolygonSpan<T>(std::span<const T>(figure.xs(), figure.size()),
+                                                   std::span<const T>(figure.ys(), figure.size()))) {}
+
+    // Вид над точками существующей фигуры
+    template<class F>
+        requires requires { F::kind; }
+    static FigureView of(const F& figure) {
+        return FigureView(F::kind, PolygonSpan<T>(figure.vertices()));
+    }
+
+    FigureKind kind() const noexcept { return _kind; }
+    const PolygonSpan<T>& vertices() const noexcept { return _vertices; }
+    size_t get_points_count() const noexcept { return _vertices.size(); }
+    Point<T> get_point(size_t i) const { return _vertices[i]; }
+
+    template<class Policy = FastArithmetic>
+    double area() const { return _vertices.template area<Policy>(); }
+
+    template<class Policy = FastArithmetic>
+    Point<T> center() const {
+        return _vertices.visit([this](auto at) { return figure_center<T, Policy>(_kind, _vertices.size(), at); });
+    }
+
+    Bounds<T> bounds() const { return _vertices.bounds(); }
+
+    explicit operator double() const { return area(); }
+
+    friend std::ostream& operator<<(std::ostream& os, const FigureView& view) {
+        return view._vertices.visit([&](auto at) -> std::ostream& { return write_figure(os, view._kind, view._vertices.size(), at); });
+    }
+
+private:
+    FigureKind _kind;
+    PolygonSpan<T> _vertices;
+};
@@ -1,62 +1,66 @@
+#pragma once
 #include <iostream>
 #include "base.h"
-
-template<class T>
-class Pentagon : public Figure<T> {
+#include "geometry.h"
+
+// CRTP-основа конкретных фигур: наследник задаёт формулу центра в
+// статической center_of, а площадь берётся из кэша Figure. center() и operator double()
+// помечены final, поэтому при вызове через конкретный тип (Rhombus<T>& и т.д.)
+// виртуального вызова нет и компилятор может встроить вычисления
+template<class Derived, class T>
+class FigureBase : public Figure<T> {
 public:
-    Pentagon() {std::cout << "Введите точки для 5-угольника:\n";}
-    Pentagon(const Pentagon<T>& other) : Figure<T>() {  
-        PointContainer<Point<T>> tmp;
-        for (size_t i = 0; i < other.get_points_count(); ++i) {
-            tmp.push_back(std::make_unique<Point<T>>(other.get_point(i)));
-        }
-        this->points = std::move(tmp);
+    using Figure<T>::Figure;
+
+    Point<T> center() const final {
+        FIGURE_TIMED(Center, 0);
+        return Derived::center_of(this->points);
     }
-    Pentagon(Pentagon<T>&& other) noexcept = default;
 
+    // Центр с выбранной политикой арифметики
+    template<class Policy>
     Point<T> center() const {
-        // Берем среднее всех координат
-        T sum_x = 0, sum_y = 0;
-        size_t count = 0;
-        
-        for (size_t i = 0; i < this->points.size(); ++i) {
-            if (i % 2 == 0) {
-                sum_x += this->points[i].getX();
-                sum_y += this->points[i].getY();
-                count++;
-            }
-        }
-        
-        if (count == 0) {
-            return Point<T>(this->points[0].getX(), this->points[0].getY());
-        }
-        
-        return Point<T>(sum_x / count, sum_y / count);
+        FIGURE_TIMED(Center, 0);
+        return Derived::template center_of<Policy>(this->points);
     }
 
     // Вычисляем площадь в приведении к типу double
-    operator double() {
-        const size_t n = this->get_points_count();
-        double sum = 0.0;
-        for (size_t i = 0; i < n; ++i) {
-            const auto &p = this->get_point(i);
-            const auto &q = this->get_point((i + 1) % n);
-            double xi = static_cast<double>(p.getX());
-            double yi = static_cast<double>(p.getY());
-            double xj = static_cast<double>(q.getX());
-            double yj = static_cast<double>(q.getY());
-            sum += xi * yj - xj * yi;
-        }
-        return std::abs(sum) * 0.5;
+    operator double() final { return this->area(); }
+};
+
+// Текстовый вывод фигуры вида kind; at(i) возвращает i-ю вершину.
+// Ромб нумерует точки с единицы, остальные фигуры - с нуля
+template<class At>
+std::ostream& write_figure(std::ostream& os, FigureKind kind, size_t n, At&& at) {
+    const bool rhombus = kind == FigureKind::Rhombus;
+    os << (rhombus ? "Ромб с " : "Фигура с ") << n << " точками:\n";
+    for (size_t i = 0; i < n; ++i) {
+        const auto& p = at(i);
+        os << "Точка " << (rhombus ? i + 1 : i) << ": (" << p.getX() << ", " << p.getY() << ")\n";
+    }
+    return os;
+}
+
+template<class T>
+class Pentagon : public FigureBase<Pentagon<T>, T> {
+    using Base = FigureBase<Pentagon<T>, T>;
+
+public:
+    static constexpr FigureKind kind = FigureKind::Pentagon;
+
+    Pentagon() = default;
+    explicit Pentagon(std::pmr::memory_resource* resource) : Base(resource) {}
+    Pentagon(const Pentagon<T>& other) : Base(other) {}
+    Pentagon(Pentagon<T>&& other) noexcept = default;
+
+    // Берем среднее координат вершин с чётными номерами
+    template<class Policy = FastArithmetic>
+    static Point<T> center_of(const PointContainer<Point<T>>& points) {
+        return pentagon_center<T, Policy>(points.size(), [&](size_t i) -> const Point<T>& { return points[i]; });
     }
 
     friend std::ostream& operator<<(std::ostream& os, const Pentagon<T>& figure) {
-        os << "Фигура с " << figure.get_points_count() << " точками:\n";
-        for (size_t i = 0; i < figure.get_points_count(); ++i) {
-            const auto& p = figure.get_point(i);
-            os << "Точка " << i << ": (" << p.getX() << ", " << p.getY() << ")\n";
-        }
-        return os;
+        return write_figure(os, kind, figure.get_points_count(), [&](size_t i) -> const Point<T>& { return figure.get_point(i); });
     }
 
     friend std::istream& operator>>(std::istream& is, Pentagon<T>& pentagon) {
@@ -71,48 +75,24 @@ public:
 
 
 template<class T>
-class Trapezoid : public Figure<T> {
+class Trapezoid : public FigureBase<Trapezoid<T>, T> {
+    using Base = FigureBase<Trapezoid<T>, T>;
+
 public:
-    Trapezoid() { std::cout << "Введите точки для трапеции\n"; }
-    Trapezoid(const Trapezoid<T>& other) : Figure<T>() {  
-        PointContainer<Point<T>> tmp;
-        for (size_t i = 0; i < other.get_points_count(); ++i) {
-            tmp.push_back(std::make_unique<Point<T>>(other.get_point(i)));
-        }
-        this->points = std::move(tmp);
-    }
+    static constexpr FigureKind kind = FigureKind::Trapezoid;
 
-    Point<T> center() const {
-        double sum_x = 0, sum_y = 0;
-        for (size_t i = 0; i < 4; ++i) {
-            sum_x += this->points[i].getX();
-            sum_y += this->points[i].getY();
-        }
-        return Point<T>(sum_x / 4, sum_y / 4);
-    }
+    Trapezoid() = default;
+    explicit Trapezoid(std::pmr::memory_resource* resource) : Base(resource) {}
+    Trapezoid(const Trapezoid<T>& other) : Base(other) {}
+    Trapezoid(Trapezoid<T>&& other) noexcept = default;
 
-    operator double() {
-        const size_t n = this->get_points_count();
-        double sum = 0.0;
-        for (size_t i = 0; i < n; ++i) {
-            const auto &p = this->get_point(i);
-            const auto &q = this->get_point((i + 1) % n);
-            double xi = static_cast<double>(p.getX());
-            double yi = static_cast<double>(p.getY());
-            double xj = static_cast<double>(q.getX());
-            double yj = static_cast<double>(q.getY());
-            sum += xi * yj - xj * yi;
-        }
-        return std::abs(sum) * 0.5;
+    template<class Policy = FastArithmetic>
+    static Point<T> center_of(const PointContainer<Point<T>>& points) {
+        return trapezoid_center<T, Policy>([&](size_t i) -> const Point<T>& { return points[i]; });
     }
 
     friend std::ostream& operator<<(std::ostream& os, const Trapezoid<T>& figure) {
-        os << "Фигура с " << figure.get_points_count() << " точками:\n";
-        for (size_t i = 0; i < figure.get_points_count(); ++i) {
-            const auto& p = figure.get_point(i);
-            os << "Точка " << i << ": (" << p.getX() << ", " << p.getY() << ")\n";
-        }
-        return os;
+        return write_figure(os, kind, figure.get_points_count(), [&](size_t i) -> const Point<T>& { return figure.get_point(i); });
     }
 
     friend std::istream& operator>>(std::istream& is, Trapezoid<T>& trapezoid) {
@@ -127,49 +107,24 @@ public:
 
 
 template<class T>
-class Rhombus : public Figure<T> {
-public:
-    Rhombus() {std::cout << "Введите точки для ромба\n";}
-    Rhombus(const Rhombus<T>& other) : Figure<T>() {  
-        PointContainer<Point<T>> tmp;
-        for (size_t i = 0; i < other.get_points_count(); ++i) {
-            tmp.push_back(std::make_unique<Point<T>>(other.get_point(i)));
-        }
-        this->points = std::move(tmp);
-    }
-    Rhombus(Rhombus<T>&& other) noexcept = default;
+class Rhombus : public FigureBase<Rhombus<T>, T> {
+    using Base = FigureBase<Rhombus<T>, T>;
 
-    Point<T> center() const {
-        const auto &A = this->points[0];
-        const auto &C = this->points[2];
-        double cx = (A.getX() + C.getX()) / 2.0;
-        double cy = (A.getY() + C.getY()) / 2.0;
+public:
+    static constexpr FigureKind kind = FigureKind::Rhombus;
 
-        return Point<T>(static_cast<T>(cx), static_cast<T>(cy));
-    }
+    Rhombus() = default;
+    explicit Rhombus(std::pmr::memory_resource* resource) : Base(resource) {}
+    Rhombus(const Rhombus<T>& other) : Base(other) {}
+    Rhombus(Rhombus<T>&& other) noexcept = default;
 
-    operator double() {
-        const size_t n = this->get_points_count();
-        double sum = 0.0;
-        for (size_t i = 0; i < n; ++i) {
-            const auto &p = this->get_point(i);
-            const auto &q = this->get_point((i + 1) % n);
-            double xi = static_cast<double>(p.getX());
-            double yi = static_cast<double>(p.getY());
-            double xj = static_cast<double>(q.getX());
-            double yj = static_cast<double>(q.getY());
-            sum += xi * yj - xj * yi;
-        }
-        return std::abs(sum) * 0.5;
+    template<class Policy = FastArithmetic>
+    static Point<T> center_of(const PointContainer<Point<T>>& points) {
+        return rhombus_center<T, Policy>([&](size_t i) -> const Point<T>& { return points[i]; });
     }
 
     friend std::ostream& operator<<(std::ostream& os, const Rhombus<T>& figure) {
-        os << "Ромб с " << figure.get_points_count() << " точками:\n";
-        for (size_t i = 0; i < figure.get_points_count(); ++i) {
-            const auto& p = figure.get_point(i);
-            os << "Точка " << i + 1 << ": (" << p.getX() << ", " << p.getY() << ")\n";
-        }
-        return os;
+        return write_figure(os, kind, figure.get_points_count(), [&](size_t i) -> const Point<T>& { return figure.get_point(i); });
     }
 
     friend std::istream& operator>>(std::istream& is, Rhombus<T>& rhombus) {
@@ -180,4 +135,26 @@ public:
         }
         return is;
     }
-};
\ No newline at end of file
+};
+
+// Многоугольник с любым числом вершин: результат отсечения, выпуклая
+// оболочка и т.п. Центр - центр масс; выводится как обычная Figure
+template<class T>
+class Polygon : public FigureBase<Polygon<T>, T> {
+    using Base = FigureBase<Polygon<T>, T>;
+
+public:
+    Polygon() = default;
+    explicit Polygon(std::pmr::memory_resource* resource) : Base(resource) {}
+    Polygon(const Polygon<T>& other) : Base(other) {}
+    Polygon(Polygon<T>&& other) noexcept = default;
+
+    // Центр масс всегда считается в double, политика не влияет
+    template<class Policy = FastArithmetic>
+    static Point<T> center_of(const PointContainer<Point<T>>& points) {
+        PolygonAccumulator<T> acc;
+        for (const auto& p : points) acc.add(p);
+        const auto c = acc.centroid();
+        return Point<T>(static_cast<T>(c.getX()), static_cast<T>(c.getY()));
+    }
+};
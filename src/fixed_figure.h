@@ -0,0 +1,78 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+#include "figures.h"
+#include "geometry.h"
+
+// Фигура с числом вершин, известным при компиляции. Вершины лежат прямо
+// в объекте (std::array), кучи нет: 32-40 байт для int, 64-80 для double.
+// Площадь и центр constexpr, циклы по вершинам развёрнуты.
+// Policy - политика арифметики из geometry.h
+template<FigureKind Kind, class T, class Policy = FastArithmetic>
+class FixedFigure {
+public:
+    static constexpr FigureKind kind = Kind;
+    static constexpr size_t arity = figure_arity(Kind);
+
+    constexpr FixedFigure() = default;
+    constexpr explicit FixedFigure(const std::array<Point<T>, arity>& points) : _points(points) {}
+
+    template<class... P>
+        requires (sizeof...(P) == arity && (std::is_convertible_v<P, Point<T>> && ...))
+    constexpr FixedFigure(const P&... points) : _points{Point<T>(points)...} {}
+
+    // Из обычной фигуры; число точек должно совпадать
+    static FixedFigure from(const Figure<T>& figure) {
+        if (figure.get_points_count() != arity) throw std::invalid_argument("Wrong number of points for figure");
+        FixedFigure result;
+        for (size_t i = 0; i < arity; ++i) result._points[i] = figure.get_point(i);
+        return result;
+    }
+
+    constexpr size_t get_points_count() const { return arity; }
+
+    constexpr const Point<T>& get_point(size_t idx) const {
+        if (idx >= arity) throw std::out_of_range("Point index out of range");
+        return _points[idx];
+    }
+
+    constexpr const std::array<Point<T>, arity>& points() const { return _points; }
+
+    constexpr double area() const {
+        return shoelace_area_fixed<arity, Policy>([this](size_t i) -> const Point<T>& { return _points[i]; });
+    }
+
+    constexpr Point<T> center() const {
+        return figure_center<T, Policy>(Kind, arity, [this](size_t i) -> const Point<T>& { return _points[i]; });
+    }
+
+    constexpr explicit operator double() const { return area(); }
+
+    friend std::ostream& operator<<(std::ostream& os, const FixedFigure& figure) {
+        return write_figure(os, Kind, arity, [&](size_t i) -> const Point<T>& { return figure._points[i]; });
+    }
+
+    friend std::istream& operator>>(std::istream& is, FixedFigure& figure) {
+        for (size_t i = 0; i < arity; ++i) {
+            T x, y;
+            if (!(is >> x >> y)) break;
+            figure._points[i] = Point<T>(x, y);
+        }
+        return is;
+    }
+
+private:
+    std::array<Point<T>, arity> _points{};
+};
+
+template<class T, class Policy = FastArithmetic>
+using FixedRhombus = FixedFigure<FigureKind::Rhombus, T, Policy>;
+
+template<class T, class Policy = FastArithmetic>
+using FixedTrapezoid = FixedFigure<FigureKind::Trapezoid, T, Policy>;
+
+template<class T, class Policy = FastArithmetic>
+using FixedPentagon = FixedFigure<FigureKind::Pentagon, T, Policy>;
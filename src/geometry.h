@@ -0,0 +1,311 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include "point.h"
+
+// Вид фигуры, нужен там, где фигуры хранятся без виртуальных классов
+enum class FigureKind : uint8_t {
+    Rhombus = 0,
+    Trapezoid = 1,
+    Pentagon = 2,
+};
+
+// Сколько вершин у фигуры данного вида
+constexpr size_t figure_arity(FigureKind kind) {
+    return kind == FigureKind::Pentagon ? 5 : 4;
+}
+
+// 128-битное целое для точных произведений координат (GCC/Clang);
+// в своём пространстве имён, чтобы не спорить с чужими int128_t
+#ifndef __SIZEOF_INT128__
+#error "Exact integer geometry needs a compiler with __int128 (GCC or Clang on a 64-bit target)"
+#endif
+
+namespace geometry_detail {
+
+__extension__ typedef __int128 int128_t;
+
+} // namespace geometry_detail
+
+// Суммирование Ноймайера (вариант Кэхэна, устойчивый к большим слагаемым)
+class CompensatedSum {
+public:
+    void add(double value) {
+        const double t = _sum + value;
+        if (std::abs(_sum) >= std::abs(value)) _c += (_sum - t) + value;
+        else _c += (value - t) + _sum;
+        _sum = t;
+    }
+
+    double value() const { return _sum + _c; }
+
+private:
+    double _sum = 0;
+    double _c = 0;
+};
+
+// Политики арифметики для формул площади и центра. Accumulator<T> копит
+// суммы координат (add) и членов формулы шнурования (add_cross)
+
+// Быстрый режим: всё считается в double. Для целых координат больше 2^26
+// произведения уже округляются
+struct FastArithmetic {
+    template<class T>
+    class Accumulator {
+    public:
+        constexpr void add(T v) { _sum += static_cast<double>(v); }
+
+        constexpr void add_cross(const Point<T>& p, const Point<T>& q) {
+            double xi = static_cast<double>(p.getX());
+            double yi = static_cast<double>(p.getY());
+            double xj = static_cast<double>(q.getX());
+            double yj = static_cast<double>(q.getY());
+            _sum += xi * yj - xj * yi;
+        }
+
+        constexpr double value() const { return _sum; }
+        constexpr T mean(size_t count) const { return static_cast<T>(_sum / count); }
+
+    private:
+        double _sum = 0.0;
+    };
+};
+
+// Точный режим для целых координат: суммы и удвоенная площадь в __int128,
+// в double переводится только готовый результат. Хватает для координат
+// по модулю до 2^61
+struct ExactArithmetic {
+    using int128_t = geometry_detail::int128_t;
+
+    template<class T>
+    class Accumulator {
+        static_assert(std::is_integral_v<T>, "ExactArithmetic needs integer coordinates");
+
+    public:
+        constexpr void add(T v) { _sum += v; }
+
+        constexpr void add_cross(const Point<T>& p, const Point<T>& q) {
+            _sum += static_cast<int128_t>(p.getX()) * q.getY() - static_cast<int128_t>(q.getX()) * p.getY();
+        }
+
+        constexpr double value() const { return static_cast<double>(_sum); }
+        constexpr int128_t exact() const { return _sum; }
+        constexpr T mean(size_t count) const { return static_cast<T>(_sum / static_cast<int128_t>(count)); }
+
+    private:
+        int128_t _sum = 0;
+    };
+};
+
+// Компенсированный режим: каждый член xi*yj - xj*yi считается почти точно
+// через fma (алгоритм Кэхэна для разности произведений), а члены
+// складываются суммированием Ноймайера. Подходит и для вещественных
+// координат
+struct CompensatedArithmetic {
+    template<class T>
+    class Accumulator {
+    public:
+        void add(T v) { _sum.add(static_cast<double>(v)); }
+
+        void add_cross(const Point<T>& p, const Point<T>& q) {
+            const double xi = static_cast<double>(p.getX());
+            const double yi = static_cast<double>(p.getY());
+            const double xj = static_cast<double>(q.getX());
+            const double yj = static_cast<double>(q.getY());
+            const double w = xj * yi;
+            const double e = std::fma(-xj, yi, w);
+            const double f = std::fma(xi, yj, -w);
+            _sum.add(f + e);
+        }
+
+        double value() const { return _sum.value(); }
+        T mean(size_t count) const { return static_cast<T>(_sum.value() / count); }
+
+    private:
+        CompensatedSum _sum;
+    };
+};
+
+// Тип координаты вершины, которую возвращает at(i)
+template<class At>
+using vertex_coord_t = std::decay_t<decltype(std::declval<At&>()(size_t{}).getX())>;
+
+// Общие формулы для всех фигур. at(i) возвращает i-ю вершину (Point<T>),
+// поэтому одни и те же функции работают и с PointContainer, и с плоскими
+// массивами координат. Все функции constexpr, поэтому для фигур,
+// известных при компиляции, результат считается компилятором.
+// Policy - одна из политик арифметики выше
+
+// Площадь методом гауссовой площади (shoelace formula)
+template<class Policy = FastArithmetic, class At>
+constexpr double shoelace_area(size_t n, At&& at) {
+    typename Policy::template Accumulator<vertex_coord_t<At>> sum;
+    for (size_t i = 0; i < n; ++i) sum.add_cross(at(i), at((i + 1) % n));
+    const double s = sum.value();
+    // std::abs не constexpr в C++20
+    return (s < 0 ? -s : s) * 0.5;
+}
+
+// То же для числа вершин N, известного при компиляции: цикл развёрнут,
+// слагаемые складываются в том же порядке, что и в shoelace_area
+template<size_t N, class Policy = FastArithmetic, class At>
+constexpr double shoelace_area_fixed(At&& at) {
+    typename Policy::template Accumulator<vertex_coord_t<At>> sum;
+    [&]<size_t... I>(std::index_sequence<I...>) {
+        (sum.add_cross(at(I), at((I + 1) % N)), ...);
+    }(std::make_index_sequence<N>{});
+    const double s = sum.value();
+    return (s < 0 ? -s : s) * 0.5;
+}
+
+// Точная удвоенная площадь для целых координат
+template<class At>
+constexpr geometry_detail::int128_t exact_twice_area(size_t n, At&& at) {
+    ExactArithmetic::Accumulator<vertex_coord_t<At>> sum;
+    for (size_t i = 0; i < n; ++i) sum.add_cross(at(i), at((i + 1) % n));
+    return sum.exact() < 0 ? -sum.exact() : sum.exact();
+}
+
+// Центр ромба - середина главной диагонали
+template<class T, class Policy = FastArithmetic, class At>
+constexpr Point<T> rhombus_center(At&& at) {
+    typename Policy::template Accumulator<T> x, y;
+    x.add(at(0).getX());
+    x.add(at(2).getX());
+    y.add(at(0).getY());
+    y.add(at(2).getY());
+    return Point<T>(x.mean(2), y.mean(2));
+}
+
+// Центр трапеции - среднее четырёх вершин
+template<class T, class Policy = FastArithmetic, class At>
+constexpr Point<T> trapezoid_center(At&& at) {
+    typename Policy::template Accumulator<T> x, y;
+    for (size_t i = 0; i < 4; ++i) {
+        x.add(at(i).getX());
+        y.add(at(i).getY());
+    }
+    return Point<T>(x.mean(4), y.mean(4));
+}
+
+// Центр пятиугольника - среднее вершин с чётными номерами. Сумма копится
+// не в T, поэтому для целых координат нет переполнения
+template<class T, class Policy = FastArithmetic, class At>
+constexpr Point<T> pentagon_center(size_t n, At&& at) {
+    typename Policy::template Accumulator<T> x, y;
+    size_t count = 0;
+    for (size_t i = 0; i < n; i += 2) {
+        x.add(at(i).getX());
+        y.add(at(i).getY());
+        count++;
+    }
+    if (count == 0) {
+        return Point<T>(at(0).getX(), at(0).getY());
+    }
+    return Point<T>(x.mean(count), y.mean(count));
+}
+
+template<class T, class Policy = FastArithmetic, class At>
+constexpr Point<T> figure_center(FigureKind kind, size_t n, At&& at) {
+    switch (kind) {
+    case FigureKind::Rhombus: return rhombus_center<T, Policy>(at);
+    case FigureKind::Trapezoid: return trapezoid_center<T, Policy>(at);
+    case FigureKind::Pentagon: return pentagon_center<T, Policy>(n, at);
+    }
+    return Point<T>();
+}
+
+// Габаритный прямоугольник
+template<class T>
+struct Bounds {
+    T min_x = T();
+    T min_y = T();
+    T max_x = T();
+    T max_y = T();
+
+    bool contains(const Point<T>& p) const {
+        return p.getX() >= min_x && p.getX() <= max_x && p.getY() >= min_y && p.getY() <= max_y;
+    }
+
+    bool intersects(const Bounds& other) const {
+        return min_x <= other.max_x && other.min_x <= max_x && min_y <= other.max_y && other.min_y <= max_y;
+    }
+};
+
+// Накопитель площади, центроида и габаритов многоугольника, который
+// обновляется за O(1) при добавлении вершины в конец.
+// Хранит сумму членов формулы шнурования без замыкающего ребра (n-1 -> 0)
+// и добавляет его при запросе, поэтому площадь совпадает с shoelace_area
+// бит в бит
+template<class T>
+class PolygonAccumulator {
+public:
+    void add(const Point<T>& p) {
+        const double x = static_cast<double>(p.getX());
+        const double y = static_cast<double>(p.getY());
+        if (_n == 0) {
+            _first = p;
+            _bounds = Bounds<T>{p.getX(), p.getY(), p.getX(), p.getY()};
+        } else {
+            const double c = cross(_last, p);
+            _chain += c;
+            _chain_cx += (static_cast<double>(_last.getX()) + x) * c;
+            _chain_cy += (static_cast<double>(_last.getY()) + y) * c;
+            _bounds.min_x = std::min(_bounds.min_x, p.getX());
+            _bounds.min_y = std::min(_bounds.min_y, p.getY());
+            _bounds.max_x = std::max(_bounds.max_x, p.getX());
+            _bounds.max_y = std::max(_bounds.max_y, p.getY());
+        }
+        _sum_x += x;
+        _sum_y += y;
+        _last = p;
+        ++_n;
+    }
+
+    size_t size() const { return _n; }
+
+    // Удвоенная ориентированная площадь (положительна при обходе против часовой)
+    double twice_signed_area() const {
+        return _n == 0 ? 0.0 : _chain + cross(_last, _first);
+    }
+
+    double signed_area() const { return twice_signed_area() * 0.5; }
+    double area() const { return std::abs(twice_signed_area()) * 0.5; }
+
+    // Центр масс многоугольника; для вырожденного (нулевой площади) -
+    // среднее вершин
+    Point<double> centroid() const {
+        if (_n == 0) return Point<double>();
+        const double s = twice_signed_area();
+        if (s == 0.0) return Point<double>(_sum_x / _n, _sum_y / _n);
+        const double c = cross(_last, _first);
+        const double cx = _chain_cx + (static_cast<double>(_last.getX()) + static_cast<double>(_first.getX())) * c;
+        const double cy = _chain_cy + (static_cast<double>(_last.getY()) + static_cast<double>(_first.getY())) * c;
+        return Point<double>(cx / (3.0 * s), cy / (3.0 * s));
+    }
+
+    Bounds<T> bounds() const { return _bounds; }
+
+private:
+    static double cross(const Point<T>& p, const Point<T>& q) {
+        double xi = static_cast<double>(p.getX());
+        double yi = static_cast<double>(p.getY());
+        double xj = static_cast<double>(q.getX());
+        double yj = static_cast<double>(q.getY());
+        return xi * yj - xj * yi;
+    }
+
+    size_t _n = 0;
+    Point<T> _first;
+    Point<T> _last;
+    double _chain = 0;
+    double _chain_cx = 0;
+    double _chain_cy = 0;
+    double _sum_x = 0;
+    double _sum_y = 0;
+    Bounds<T> _bounds;
+};
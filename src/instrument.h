@@ -0,0 +1,289 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Счётчики горячих путей: выделения памяти в PointContainer/Array,
+// перевыделения в Array, копирования фигур, вычисления площади и центра.
+// Включаются макросом FIGURE_INSTRUMENT (опция CMake FIGURE_INSTRUMENT),
+// без него макросы FIGURE_COUNT/FIGURE_TIMED раскрываются в пустоту и
+// в коде не остаётся ни одной инструкции.
+// У каждого потока свой блок счётчиков: пишет в него только сам поток
+// (relaxed load + store, без блокировок и RMW), snapshot() суммирует блоки.
+// Мьютекс берётся только при появлении и завершении потока
+
+#if defined(FIGURE_INSTRUMENT) && FIGURE_INSTRUMENT
+inline constexpr bool kInstrumentEnabled = true;
+#else
+inline constexpr bool kInstrumentEnabled = false;
+#endif
+
+enum class Counter : uint8_t {
+    ContainerAlloc,
+    ArrayAlloc,
+    ArrayRealloc,
+    FigureCopy,
+    Area,
+    Center,
+    Count_,
+};
+
+inline constexpr size_t kCounterCount = static_cast<size_t>(Counter::Count_);
+
+inline const char* counter_name(Counter counter) {
+    switch (counter) {
+    case Counter::ContainerAlloc: return "container_alloc";
+    case Counter::ArrayAlloc: return "array_alloc";
+    case Counter::ArrayRealloc: return "array_realloc";
+    case Counter::FigureCopy: return "figure_copy";
+    case Counter::Area: return "area";
+    case Counter::Center: return "center";
+    case Counter::Count_: break;
+    }
+    return "unknown";
+}
+
+struct CounterStats {
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+    uint64_t nanos = 0;
+    uint64_t cycles = 0;
+};
+
+struct InstrumentSnapshot {
+    std::array<CounterStats, kCounterCount> stats{};
+
+    const CounterStats& operator[](Counter counter) const { return stats[static_cast<size_t>(counter)]; }
+};
+
+namespace instrument_detail {
+
+// Счётчик тактов через perf_event (Linux). Один дескриптор на поток,
+// открывается лениво; если ядро не даёт доступа - available() == false
+class PerfCycleCounter {
+public:
+    PerfCycleCounter() {
+#if defined(__linux__)
+        perf_event_attr attr{};
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CPU_CYCLES;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        _fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+    }
+
+    ~PerfCycleCounter() {
+#if defined(__linux__)
+        if (_fd >= 0) close(_fd);
+#endif
+    }
+
+    PerfCycleCounter(const PerfCycleCounter&) = delete;
+    PerfCycleCounter& operator=(const PerfCycleCounter&) = delete;
+
+    bool available() const noexcept { return _fd >= 0; }
+
+    uint64_t read_cycles() const noexcept {
+        uint64_t value = 0;
+#if defined(__linux__)
+        if (_fd >= 0 && ::read(_fd, &value, sizeof(value)) != sizeof(value)) value = 0;
+#endif
+        return value;
+    }
+
+private:
+    int _fd = -1;
+};
+
+struct Cell {
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> nanos{0};
+    std::atomic<uint64_t> cycles{0};
+};
+
+// Прибавление к ячейке, в которую пишет только один поток
+inline void bump(std::atomic<uint64_t>& cell, uint64_t value) noexcept {
+    cell.store(cell.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+using Block = std::array<Cell, kCounterCount>;
+
+// Живые блоки потоков и сумма по завершившимся потокам
+class Registry {
+public:
+    void attach(Block* block) {
+        std::lock_guard lock(_mutex);
+        _blocks.push_back(block);
+    }
+
+    void detach(Block* block) {
+        std::lock_guard lock(_mutex);
+        for (size_t i = 0; i < kCounterCount; ++i) add(_retired[i], (*block)[i]);
+        std::erase(_blocks, block);
+    }
+
+    InstrumentSnapshot snapshot() {
+        std::lock_guard lock(_mutex);
+        InstrumentSnapshot result;
+        result.stats = _retired;
+        for (Block* block : _blocks) {
+            for (size_t i = 0; i < kCounterCount; ++i) add(result.stats[i], (*block)[i]);
+        }
+        return result;
+    }
+
+    // Обнуление; счётчики других потоков, работающих в этот момент, могут
+    // частично пережить сброс
+    void reset() {
+        std::lock_guard lock(_mutex);
+        _retired = {};
+        for (Block* block : _blocks) {
+            for (Cell& cell : *block) {
+                cell.count.store(0, std::memory_order_relaxed);
+                cell.bytes.store(0, std::memory_order_relaxed);
+                cell.nanos.store(0, std::memory_order_relaxed);
+                cell.cycles.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    std::atomic<bool> cycles_enabled{false};
+
+private:
+    static void add(CounterStats& to, const Cell& from) {
+        to.count += from.count.load(std::memory_order_relaxed);
+        to.bytes += from.bytes.load(std::memory_order_relaxed);
+        to.nanos += from.nanos.load(std::memory_order_relaxed);
+        to.cycles += from.cycles.load(std::memory_order_relaxed);
+    }
+
+    std::mutex _mutex;
+    std::vector<Block*> _blocks;
+    std::array<CounterStats, kCounterCount> _retired{};
+};
+
+inline Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+class ThreadSlot {
+public:
+    ThreadSlot() { registry().attach(&block); }
+    ~ThreadSlot() { registry().detach(&block); }
+
+    ThreadSlot(const ThreadSlot&) = delete;
+    ThreadSlot& operator=(const ThreadSlot&) = delete;
+
+    PerfCycleCounter& perf() {
+        if (!_perf) _perf = std::make_unique<PerfCycleCounter>();
+        return *_perf;
+    }
+
+    Block block;
+
+private:
+    std::unique_ptr<PerfCycleCounter> _perf;
+};
+
+inline ThreadSlot& slot() {
+    thread_local ThreadSlot instance;
+    return instance;
+}
+
+inline Cell& cell(Counter counter) { return slot().block[static_cast<size_t>(counter)]; }
+
+} // namespace instrument_detail
+
+inline void instrument_count(Counter counter, uint64_t bytes = 0) noexcept {
+    auto& c = instrument_detail::cell(counter);
+    instrument_detail::bump(c.count, 1);
+    if (bytes) instrument_detail::bump(c.bytes, bytes);
+}
+
+// Время (и такты, если включены) от создания до разрушения объекта
+class ScopedInstrumentTimer {
+public:
+    explicit ScopedInstrumentTimer(Counter counter, uint64_t bytes = 0) noexcept
+        : _cell(instrument_detail::cell(counter)), _start(std::chrono::steady_clock::now()) {
+        instrument_detail::bump(_cell.count, 1);
+        if (bytes) instrument_detail::bump(_cell.bytes, bytes);
+        if (instrument_detail::registry().cycles_enabled.load(std::memory_order_relaxed)) {
+            auto& perf = instrument_detail::slot().perf();
+            if (perf.available()) {
+                _perf = &perf;
+                _start_cycles = perf.read_cycles();
+            }
+        }
+    }
+
+    ~ScopedInstrumentTimer() {
+        const auto elapsed = std::chrono::steady_clock::now() - _start;
+        instrument_detail::bump(_cell.nanos, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        if (_perf) instrument_detail::bump(_cell.cycles, _perf->read_cycles() - _start_cycles);
+    }
+
+    ScopedInstrumentTimer(const ScopedInstrumentTimer&) = delete;
+    ScopedInstrumentTimer& operator=(const ScopedInstrumentTimer&) = delete;
+
+private:
+    instrument_detail::Cell& _cell;
+    std::chrono::steady_clock::time_point _start;
+    instrument_detail::PerfCycleCounter* _perf = nullptr;
+    uint64_t _start_cycles = 0;
+};
+
+// Сумма счётчиков всех потоков, включая завершившиеся
+inline InstrumentSnapshot instrument_snapshot() { return instrument_detail::registry().snapshot(); }
+
+inline void instrument_reset() { instrument_detail::registry().reset(); }
+
+// Подсчёт тактов через perf_event; возвращает false, если он недоступен
+inline bool instrument_enable_cycles(bool enable) {
+    instrument_detail::registry().cycles_enabled.store(enable, std::memory_order_relaxed);
+    return !enable || instrument_detail::slot().perf().available();
+}
+
+inline void dump_text(std::ostream& os, const InstrumentSnapshot& snapshot) {
+    for (size_t i = 0; i < kCounterCount; ++i) {
+        const auto& s = snapshot.stats[i];
+        os << counter_name(static_cast<Counter>(i)) << ": count=" << s.count << " bytes=" << s.bytes
+           << " ns=" << s.nanos << " cycles=" << s.cycles << '\n';
+    }
+}
+
+inline void dump_json(std::ostream& os, const InstrumentSnapshot& snapshot) {
+    os << '{';
+    for (size_t i = 0; i < kCounterCount; ++i) {
+        const auto& s = snapshot.stats[i];
+        if (i) os << ',';
+        os << '"' << counter_name(static_cast<Counter>(i)) << "\":{\"count\":" << s.count << ",\"bytes\":" << s.bytes
+           << ",\"ns\":" << s.nanos << ",\"cycles\":" << s.cycles << '}';
+    }
+    os << "}\n";
+}
+
+#if defined(FIGURE_INSTRUMENT) && FIGURE_INSTRUMENT
+#define FIGURE_INSTRUMENT_CONCAT_(a, b) a##b
+#define FIGURE_INSTRUMENT_CONCAT(a, b) FIGURE_INSTRUMENT_CONCAT_(a, b)
+#define FIGURE_COUNT(counter, bytes) instrument_count(Counter::counter, (bytes))
+#define FIGURE_TIMED(counter, bytes) \
+    ScopedInstrumentTimer FIGURE_INSTRUMENT_CONCAT(figure_timer_, __LINE__)(Counter::counter, (bytes))
+#else
+#define FIGURE_COUNT(counter, bytes) ((void)0)
+#define FIGURE_TIMED(counter, bytes) ((void)0)
+#endif
@@ -1,11 +1,70 @@
+#include <charconv>
+#include <cstring>
+#include <fstream>
 #include <iostream>
 #include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
 #include "figures.h"
 #include "array.h"
+#include "pipeline.h"
 
 using namespace std;
 
-int main() {
+// Пакетный режим: figure --batch [файл|-] [--threads N]
+// Фигуры в текстовом формате (см. text_parser.h) читаются из файла или stdin,
+// на каждую выводится площадь и центр, в конце - итоги
+static int run_batch(int argc, char** argv) {
+    try {
+        string path = "-";
+        bool has_path = false;
+        PipelineOptions options;
+        for (int i = 2; i < argc; ++i) {
+            const string_view arg = argv[i];
+            if (arg == "--threads") {
+                if (i + 1 == argc) {
+                    cerr << "Ошибка: для --threads нужно число потоков\n";
+                    return 1;
+                }
+                const string_view value = argv[++i];
+                const auto [end, ec] = from_chars(value.data(), value.data() + value.size(), options.workers);
+                if (value.empty() || ec != errc() || end != value.data() + value.size()) {
+                    cerr << "Ошибка: неверное число потоков: " << value << "\n";
+                    return 1;
+                }
+            } else if (arg.size() > 1 && arg[0] == '-') {
+                cerr << "Ошибка: неизвестный параметр " << arg << "\n";
+                return 1;
+            } else if (has_path) {
+                cerr << "Ошибка: лишний аргумент " << arg << "\n";
+                return 1;
+            } else {
+                path = arg;
+                has_path = true;
+            }
+        }
+
+        ios::sync_with_stdio(false);
+        if (path == "-") {
+            run_pipeline<double>(cin, cout, options);
+        } else {
+            ifstream file(path, ios::binary);
+            if (!file) {
+                cerr << "Не удалось открыть " << path << "\n";
+                return 1;
+            }
+            run_pipeline<double>(file, cout, options);
+        }
+    } catch (const exception& e) {
+        cerr << "Ошибка: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1 && strcmp(argv[1], "--batch") == 0) return run_batch(argc, argv);
 
     //  @@@     @@@    @@@@@@
     // @   @   @   @   @    @
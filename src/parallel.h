@@ -0,0 +1,190 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "array.h"
+#include "base.h"
+
+// Пул потоков с кражей работы: у каждого потока своя очередь задач,
+// свои задачи он берёт с начала очереди, а закончив их, крадёт с конца
+// чужих очередей
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threads = 0) {
+        if (threads == 0) threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+        for (size_t i = 0; i < threads; ++i) _queues.push_back(std::make_unique<Queue>());
+        for (size_t i = 0; i < threads; ++i) _workers.emplace_back([this, i] { run(i); });
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _wake.notify_all();
+        for (auto& w : _workers) w.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const noexcept { return _workers.size(); }
+
+    void submit(std::function<void()> task) {
+        const size_t q = _next.fetch_add(1, std::memory_order_relaxed) % _queues.size();
+        {
+            // Счётчики увеличиваем до того, как задача попадёт в очередь,
+            // иначе её могут выполнить раньше, чем мы её посчитали
+            std::lock_guard<std::mutex> lock(_mutex);
+            ++_pending;
+            ++_queued;
+        }
+        {
+            std::lock_guard<std::mutex> lock(_queues[q]->mutex);
+            _queues[q]->tasks.push_back(std::move(task));
+        }
+        _wake.notify_one();
+    }
+
+    // Ждём завершения всех задач; первое исключение из задач пробрасывается
+    void wait() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _idle.wait(lock, [this] { return _pending == 0; });
+        if (_error) {
+            std::exception_ptr e = std::exchange(_error, nullptr);
+            std::rethrow_exception(e);
+        }
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    bool try_pop(size_t self, std::function<void()>& task) {
+        {
+            Queue& own = *_queues[self];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty()) {
+                task = std::move(own.tasks.front());
+                own.tasks.pop_front();
+                return true;
+            }
+        }
+        for (size_t k = 1; k < _queues.size(); ++k) {
+            Queue& other = *_queues[(self + k) % _queues.size()];
+            std::lock_guard<std::mutex> lock(other.mutex);
+            if (!other.tasks.empty()) {
+                task = std::move(other.tasks.back());
+                other.tasks.pop_back();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void run(size_t self) {
+        for (;;) {
+            std::function<void()> task;
+            if (try_pop(self, task)) {
+                {
+                    std::lock_guard<std::mutex> lock(_mutex);
+                    --_queued;
+                }
+                std::exception_ptr error;
+                try {
+                    task();
+                } catch (...) {
+                    error = std::current_exception();
+                }
+                std::lock_guard<std::mutex> lock(_mutex);
+                if (error && !_error) _error = error;
+                if (--_pending == 0) _idle.notify_all();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(_mutex);
+            _wake.wait(lock, [this] { return _stop || _queued > 0; });
+            if (_stop && _queued == 0) return;
+        }
+    }
+
+    std::vector<std::unique_ptr<Queue>> _queues;
+    std::vector<std::thread> _workers;
+    std::atomic<size_t> _next{0};
+    std::mutex _mutex;
+    std::condition_variable _wake;
+    std::condition_variable _idle;
+    size_t _pending = 0;
+    size_t _queued = 0;
+    bool _stop = false;
+    std::exception_ptr _error;
+};
+
+// Сколько фигур обрабатывает одна задача. Фигура вместе с shared_ptr и
+// блоком счётчика занимает порядка 128 байт, так что кусок примерно
+// помещается в L2. Разбиение не зависит от числа потоков, поэтому и сумма
+// не зависит от него
+inline constexpr size_t kParallelChunk = 4096;
+
+// Попарное суммирование частичных сумм в фиксированном порядке
+inline double pairwise_sum(const double* values, size_t n) {
+    if (n == 0) return 0;
+    if (n == 1) return values[0];
+    const size_t half = n / 2;
+    return pairwise_sum(values, half) + pairwise_sum(values + half, n - half);
+}
+
+// Запускает body(first, last) для кусков [0, n) размера chunk и ждёт их
+template<class Body>
+void parallel_chunks(ThreadPool& pool, size_t n, size_t chunk, Body body) {
+    for (size_t first = 0; first < n; first += chunk) {
+        const size_t last = std::min(n, first + chunk);
+        pool.submit([&body, first, last] { body(first, last); });
+    }
+    pool.wait();
+}
+
+// Общая площадь фигур; результат одинаков при любом числе потоков
+template<class T>
+double parallel_total_area(const Array<std::shared_ptr<Figure<T>>>& figures, ThreadPool& pool) {
+    const size_t n = figures.size();
+    std::vector<double> partial((n + kParallelChunk - 1) / kParallelChunk);
+    parallel_chunks(pool, n, kParallelChunk, [&](size_t first, size_t last) {
+        CompensatedSum sum;
+        for (size_t i = first; i < last; ++i) sum.add(static_cast<double>(*figures[i]));
+        partial[first / kParallelChunk] = sum.value();
+    });
+    return pairwise_sum(partial.data(), partial.size());
+}
+
+template<class T>
+double parallel_total_area(const Array<std::shared_ptr<Figure<T>>>& figures, size_t threads = 0) {
+    ThreadPool pool(threads);
+    return parallel_total_area(figures, pool);
+}
+
+// Центры всех фигур, out[i] - центр figures[i]
+template<class T>
+void parallel_centers(const Array<std::shared_ptr<Figure<T>>>& figures, Array<Point<T>>& out, ThreadPool& pool) {
+    out.resize(figures.size());
+    parallel_chunks(pool, figures.size(), kParallelChunk, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i) out[i] = figures[i]->center();
+    });
+}
+
+template<class T>
+void parallel_centers(const Array<std::shared_ptr<Figure<T>>>& figures, Array<Point<T>>& out, size_t threads = 0) {
+    ThreadPool pool(threads);
+    parallel_centers(figures, out, pool);
+}
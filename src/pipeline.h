@@ -0,0 +1,360 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstddef>
+#include <exception>
+#include <istream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "simd_area.h"
+#include "text_parser.h"
+
+// Потоковая обработка фигур в три стадии: поток чтения режет вход на
+// пачки целых строк, рабочие потоки разбирают пачки и считают площади и
+// центры, поток записи выводит результаты в порядке входа и считает итоги.
+// Стадии связаны ограниченными очередями, поэтому память не растёт с
+// размером входа: в работе не больше queue_capacity пачек на очередь плюс
+// по одной на рабочий поток.
+//
+// Вывод: строка на фигуру "номер вид площадь x y" (вид - R/T/P, как во
+// входе), в конце - число фигур и общая площадь:
+//
+//   0 R 8 2 0
+//   1 P 5 1 1
+//   figures: 2
+//   total area: 13
+
+// Ограниченная очередь для многих писателей и читателей без блокировок
+// (кольцевой буфер с номерами ячеек, схема Вьюкова). На пустой или полной
+// очереди push/pop сначала недолго крутятся, уступая процессор, а потом
+// засыпают в atomic::wait на счётчике операций другой стороны
+template<class T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) size *= 2;
+        _mask = size - 1;
+        _cells = std::make_unique<Cell[]>(size);
+        for (size_t i = 0; i < size; ++i) _cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    size_t capacity() const noexcept { return _mask + 1; }
+
+    bool try_push(T& value) {
+        size_t pos = _tail.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = _cells[pos & _mask];
+            const size_t seq = cell.seq.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(seq - pos);
+            if (diff == 0) {
+                if (_tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.seq.store(pos + 1, std::memory_order_release);
+                    wake(_pushed);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = _tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool try_pop(T& value) {
+        size_t pos = _head.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = _cells[pos & _mask];
+            const size_t seq = cell.seq.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(seq - (pos + 1));
+            if (diff == 0) {
+                if (_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    value = std::move(cell.value);
+                    cell.seq.store(pos + _mask + 1, std::memory_order_release);
+                    wake(_popped);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = _head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Счётчик читается до попытки: если место освободили после неё,
+    // wait сразу вернётся, и пробуждение не теряется
+    void push(T value) {
+        for (unsigned spins = 0;; ++spins) {
+            const unsigned seen = _popped.load(std::memory_order_acquire);
+            if (try_push(value)) return;
+            backoff(spins, _popped, seen);
+        }
+    }
+
+    // false - очередь закрыта и пуста
+    bool pop(T& value) {
+        for (unsigned spins = 0;; ++spins) {
+            const unsigned seen = _pushed.load(std::memory_order_acquire);
+            if (try_pop(value)) return true;
+            // Всё, что положили до close(), уже видно после acquire
+            if (_closed.load(std::memory_order_acquire)) return try_pop(value);
+            backoff(spins, _pushed, seen);
+        }
+    }
+
+    // Больше ничего не добавят; читатели доберут остаток и остановятся
+    void close() noexcept {
+        _closed.store(true, std::memory_order_release);
+        wake(_pushed);
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> seq;
+        T value;
+    };
+
+    static constexpr unsigned kSpins = 64;
+    static constexpr unsigned kYields = 16;
+
+    static void wake(std::atomic<unsigned>& counter) noexcept {
+        counter.fetch_add(1, std::memory_order_release);
+        counter.notify_all();
+    }
+
+    static void backoff(unsigned spins, const std::atomic<unsigned>& counter, unsigned seen) {
+        if (spins < kSpins) return;
+        if (spins < kSpins + kYields) std::this_thread::yield();
+        else counter.wait(seen, std::memory_order_acquire);
+    }
+
+    std::unique_ptr<Cell[]> _cells;
+    size_t _mask = 0;
+    alignas(64) std::atomic<size_t> _tail{0};
+    alignas(64) std::atomic<size_t> _head{0};
+    alignas(64) std::atomic<bool> _closed{false};
+    // Число удачных push (и close) и pop - на них спят ждущие
+    alignas(64) std::atomic<unsigned> _pushed{0};
+    alignas(64) std::atomic<unsigned> _popped{0};
+};
+
+struct PipelineOptions {
+    size_t workers = 0;                     // 0 - по числу ядер
+    size_t batch_bytes = size_t(1) << 20;   // примерный размер пачки
+    size_t queue_capacity = 0;              // 0 - вдвое больше рабочих
+};
+
+struct PipelineStats {
+    size_t figures = 0;
+    double total_area = 0;
+};
+
+namespace pipeline_detail {
+
+struct Batch {
+    size_t seq = 0;
+    size_t first_line = 1;
+    std::string text;
+};
+
+struct Result {
+    size_t seq = 0;
+    size_t figures = 0;
+    double area = 0;
+    std::string output;
+    std::exception_ptr error;
+};
+
+inline char kind_tag(FigureKind kind) {
+    switch (kind) {
+    case FigureKind::Rhombus: return 'R';
+    case FigureKind::Trapezoid: return 'T';
+    case FigureKind::Pentagon: return 'P';
+    }
+    return '?';
+}
+
+template<class V>
+void append_number(std::string& out, V value) {
+    char buffer[32];
+    const auto [end, ec] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, ec == std::errc() ? end : buffer);
+}
+
+// Разбор пачки и строки вывода для неё; номера фигур в пачке известны
+// только после разбора, поэтому сдвиг нумерации добавляет поток записи.
+// При ошибке разбора выводятся фигуры до ошибочной строки, а ошибка
+// кладётся в result.error
+template<class T>
+void process(const Batch& batch, Result& result) {
+    FigureStore<T> store;
+    if (auto e = text_detail::parse_chunk(std::string_view(batch.text), 0, batch.text.size(), store)) {
+        const ParseError local = text_detail::make_error(batch.text, *e);
+        result.error = std::make_exception_ptr(
+            ParseError(e->message, local.line() + batch.first_line - 1, local.column()));
+    }
+    const std::vector<double> values = areas(store);
+    result.figures = store.size();
+    result.output.reserve(store.size() * 48);
+    CompensatedSum sum;
+    for (size_t i = 0; i < store.size(); ++i) {
+        const Point<T> c = store.center(i);
+        result.output += kind_tag(store.kind(i));
+        result.output += ' ';
+        append_number(result.output, values[i]);
+        result.output += ' ';
+        append_number(result.output, c.getX());
+        result.output += ' ';
+        append_number(result.output, c.getY());
+        result.output += '\n';
+        sum.add(values[i]);
+    }
+    result.area = sum.value();
+}
+
+} // namespace pipeline_detail
+
+// Обработка потока фигур из in с выводом в out. Ошибка разбора (ParseError
+// с номером строки во всём входе) или исключение любой стадии
+// останавливает конвейер и пробрасывается после остановки всех потоков.
+// Все фигуры до ошибочной строки к этому времени уже выведены, как бы
+// вход ни делился на пачки; итоговых строк при ошибке нет
+template<Pointable T>
+    requires std::is_arithmetic_v<T>
+PipelineStats run_pipeline(std::istream& in, std::ostream& out, PipelineOptions options = {}) {
+    using namespace pipeline_detail;
+    const size_t workers = options.workers ? options.workers : std::max<size_t>(1, std::thread::hardware_concurrency());
+    const size_t capacity = options.queue_capacity ? options.queue_capacity : 2 * workers;
+    const size_t batch_bytes = std::max<size_t>(options.batch_bytes, 1);
+    BoundedQueue<Batch> batches(capacity);
+    BoundedQueue<Result> results(capacity);
+    std::atomic<bool> stop{false};
+    std::exception_ptr reader_error;
+
+    std::thread reader([&] {
+        try {
+            std::string carry;
+            size_t seq = 0, line = 1;
+            while (!stop.load(std::memory_order_relaxed)) {
+                Batch batch;
+                batch.text = std::move(carry);
+                carry.clear();
+                const size_t have = batch.text.size();
+                batch.text.resize(have + batch_bytes);
+                in.read(batch.text.data() + have, static_cast<std::streamsize>(batch_bytes));
+                batch.text.resize(have + static_cast<size_t>(in.gcount()));
+                const bool eof = !in;
+                if (in.bad()) throw std::runtime_error("Failed to read figures");
+                // Неполную последнюю строку переносим в следующую пачку
+                if (!eof) {
+                    const size_t cut = batch.text.rfind('\n');
+                    if (cut == std::string::npos) {
+                        carry = std::move(batch.text);
+                        continue;
+                    }
+                    carry.assign(batch.text, cut + 1);
+                    batch.text.resize(cut + 1);
+                }
+                batch.seq = seq++;
+                batch.first_line = line;
+                line += static_cast<size_t>(std::count(batch.text.begin(), batch.text.end(), '\n'));
+                batches.push(std::move(batch));
+                if (eof) break;
+            }
+        } catch (...) {
+            reader_error = std::current_exception();
+        }
+        batches.close();
+    });
+
+    std::atomic<size_t> running{workers};
+    std::vector<std::thread> pool;
+    for (size_t w = 0; w < workers; ++w) {
+        pool.emplace_back([&] {
+            Batch batch;
+            while (batches.pop(batch)) {
+                Result result;
+                result.seq = batch.seq;
+                if (!stop.load(std::memory_order_relaxed)) {
+                    try {
+                        process<T>(batch, result);
+                    } catch (...) {
+                        result.error = std::current_exception();
+                    }
+                }
+                results.push(std::move(result));
+            }
+            if (running.fetch_sub(1, std::memory_order_acq_rel) == 1) results.close();
+        });
+    }
+
+    // Запись в этом потоке: пачки выводятся строго по порядку, пришедшие
+    // раньше времени ждут в pending (их не больше, чем пачек в работе)
+    PipelineStats stats;
+    CompensatedSum total;
+    std::exception_ptr error;
+    std::map<size_t, Result> pending;
+    size_t next = 0;
+    std::string buffer;
+    Result result;
+    while (results.pop(result)) {
+        pending.emplace(result.seq, std::move(result));
+        for (auto it = pending.find(next); it != pending.end(); it = pending.find(next)) {
+            Result& ready = it->second;
+            if (!error) {
+                // Номер фигуры - сквозной по всему входу; пачка уходит в out
+                // одной записью
+                const std::string_view text(ready.output);
+                buffer.clear();
+                buffer.reserve(text.size() + ready.figures * 8);
+                for (size_t pos = 0, i = 0; pos < text.size(); ++i) {
+                    const size_t eol = text.find('\n', pos);
+                    append_number(buffer, stats.figures + i);
+                    buffer += ' ';
+                    buffer.append(text, pos, eol + 1 - pos);
+                    pos = eol + 1;
+                }
+                out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                stats.figures += ready.figures;
+                total.add(ready.area);
+                if (ready.error) {
+                    error = ready.error;
+                    stop.store(true, std::memory_order_relaxed);
+                }
+            }
+            pending.erase(it);
+            ++next;
+        }
+    }
+    reader.join();
+    for (auto& t : pool) t.join();
+    if (!error) error = reader_error;
+    if (error) {
+        out.flush();
+        std::rethrow_exception(error);
+    }
+
+    stats.total_area = total.value();
+    buffer = "figures: ";
+    append_number(buffer, stats.figures);
+    buffer += "\ntotal area: ";
+    append_number(buffer, stats.total_area);
+    buffer += '\n';
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    out.flush();
+    return stats;
+}
@@ -1,3 +1,4 @@
+#pragma once
 #include <type_traits>
 
 template<class T>
@@ -7,10 +8,10 @@ concept Pointable = std::is_scalar_v<T>;
 template<Pointable T>
 class Point {
 public:
-    Point(T x = T(), T y = T()) : _x(x), _y(y) {}
+    constexpr Point(T x = T(), T y = T()) : _x(x), _y(y) {}
 
-    T getX() const {return _x;}
-    T getY() const {return _y;}
+    constexpr T getX() const {return _x;}
+    constexpr T getY() const {return _y;}
     
 private:
     T _x;
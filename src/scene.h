@@ -0,0 +1,196 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <vector>
+#include "base.h"
+#include "parallel.h"
+
+// Сцена для одновременной работы писателя и многих читателей. Фигуры только
+// добавляются и никогда не переезжают: они лежат в сегментах, i-й сегмент
+// вдвое больше предыдущего, а таблица сегментов - массив фиксированного
+// размера. Поэтому освобождать старые копии не нужно (нет RCU/эпох), а
+// чтение не берёт блокировок: снимок - это число фигур на момент запроса,
+// и все фигуры до него уже опубликованы.
+// Писатели упорядочены мьютексом, который читатели не трогают. Фигуры в
+// сцене неизменяемы (shared_ptr<const Figure>)
+
+template<class T>
+class SceneSnapshot;
+
+template<class T>
+class Scene {
+public:
+    using value_type = std::shared_ptr<const Figure<T>>;
+
+    // Размер первого сегмента; сегментов хватает на 2^48 фигур
+    static constexpr size_t kFirstSegment = 64;
+    static constexpr size_t kMaxSegments = 42;
+
+    Scene() = default;
+
+    ~Scene() {
+        const size_t n = _size.load(std::memory_order_relaxed);
+        for (size_t s = 0; s < kMaxSegments; ++s) {
+            value_type* segment = _segments[s].load(std::memory_order_relaxed);
+            if (!segment) break;
+            const size_t first = segment_start(s);
+            if (n > first) std::destroy_n(segment, std::min(n - first, segment_capacity(s)));
+            std::allocator<value_type>().deallocate(segment, segment_capacity(s));
+        }
+    }
+
+    Scene(const Scene&) = delete;
+    Scene& operator=(const Scene&) = delete;
+
+    void push_back(value_type figure) {
+        if (!figure) throw std::invalid_argument("Null figure");
+        std::lock_guard lock(_write);
+        const size_t n = _size.load(std::memory_order_relaxed);
+        std::construct_at(slot(n), std::move(figure));
+        _size.store(n + 1, std::memory_order_release);
+    }
+
+    template<class F, class... Args>
+    void emplace_back(Args&&... args) {
+        push_back(std::make_shared<const F>(std::forward<Args>(args)...));
+    }
+
+    // Пачка фигур публикуется разом: читатели увидят либо все, либо ни одной
+    template<class Range>
+    void append(const Range& figures) {
+        std::lock_guard lock(_write);
+        const size_t n = _size.load(std::memory_order_relaxed);
+        size_t added = 0;
+        try {
+            for (const auto& figure : figures) {
+                if (!figure) throw std::invalid_argument("Null figure");
+                std::construct_at(slot(n + added), figure);
+                ++added;
+            }
+        } catch (...) {
+            for (size_t i = 0; i < added; ++i) std::destroy_at(element(n + i));
+            throw;
+        }
+        _size.store(n + added, std::memory_order_release);
+    }
+
+    size_t size() const noexcept { return _size.load(std::memory_order_acquire); }
+
+    // Согласованный вид на сцену; писатель дальше не влияет на снимок
+    SceneSnapshot<T> snapshot() const noexcept { return SceneSnapshot<T>(this, size()); }
+
+    // Номер сегмента для индекса и начало/размер сегмента
+    static size_t segment_of(size_t i) noexcept {
+        return std::bit_width(i + kFirstSegment) - std::bit_width(kFirstSegment);
+    }
+    static size_t segment_start(size_t s) noexcept { return kFirstSegment * ((size_t(1) << s) - 1); }
+    static size_t segment_capacity(size_t s) noexcept { return kFirstSegment << s; }
+
+private:
+    friend class SceneSnapshot<T>;
+
+    // Элемент i; индекс уже опубликован, поэтому сегмент точно есть.
+    // Сегмент записан до публикации размера, acquire на _size делает его
+    // видимым, так что здесь хватает relaxed
+    value_type* element(size_t i) const noexcept {
+        const size_t s = segment_of(i);
+        return _segments[s].load(std::memory_order_relaxed) + (i - segment_start(s));
+    }
+
+    // Место под элемент n, при необходимости с новым сегментом (под мьютексом)
+    value_type* slot(size_t n) {
+        const size_t s = segment_of(n);
+        if (s >= kMaxSegments) throw std::length_error("Scene is full");
+        value_type* segment = _segments[s].load(std::memory_order_relaxed);
+        if (!segment) {
+            segment = std::allocator<value_type>().allocate(segment_capacity(s));
+            _segments[s].store(segment, std::memory_order_release);
+        }
+        return segment + (n - segment_start(s));
+    }
+
+    std::array<std::atomic<value_type*>, kMaxSegments> _segments{};
+    std::atomic<size_t> _size{0};
+    std::mutex _write;
+};
+
+// Снимок сцены: первые size() фигур. Действителен, пока жива сцена
+template<class T>
+class SceneSnapshot {
+public:
+    using value_type = typename Scene<T>::value_type;
+
+    class iterator {
+    public:
+        using value_type = typename Scene<T>::value_type;
+        using difference_type = std::ptrdiff_t;
+        using iterator_category = std::input_iterator_tag;
+
+        iterator() = default;
+        iterator(const Scene<T>* scene, size_t i) : _scene(scene), _i(i) {}
+
+        const value_type& operator*() const { return *_scene->element(_i); }
+        iterator& operator++() { ++_i; return *this; }
+        iterator operator++(int) { iterator tmp = *this; ++_i; return tmp; }
+        bool operator==(const iterator& other) const { return _i == other._i; }
+
+    private:
+        const Scene<T>* _scene = nullptr;
+        size_t _i = 0;
+    };
+
+    SceneSnapshot(const Scene<T>* scene, size_t n) noexcept : _scene(scene), _n(n) {}
+
+    size_t size() const noexcept { return _n; }
+    bool empty() const noexcept { return _n == 0; }
+
+    iterator begin() const { return iterator(_scene, 0); }
+    iterator end() const { return iterator(_scene, _n); }
+
+    const value_type& operator[](size_t i) const {
+        if (i >= _n) throw std::out_of_range("Index out of range");
+        return *_scene->element(i);
+    }
+
+    // f(span) для каждого непрерывного куска снимка, по порядку
+    template<class F>
+    void visit_segments(F&& f) const {
+        for (size_t s = 0, first = 0; first < _n; first += Scene<T>::segment_capacity(s), ++s) {
+            const size_t count = std::min(_n - first, Scene<T>::segment_capacity(s));
+            f(std::span<const value_type>(_scene->element(first), count));
+        }
+    }
+
+    double total_area() const {
+        CompensatedSum sum;
+        visit_segments([&](std::span<const value_type> figures) {
+            for (const auto& figure : figures) sum.add(figure->area());
+        });
+        return sum.value();
+    }
+
+private:
+    const Scene<T>* _scene;
+    size_t _n;
+};
+
+// Общая площадь снимка; разбиение то же, что у parallel_total_area для
+// Array, поэтому результат не зависит от числа потоков
+template<class T>
+double parallel_total_area(const SceneSnapshot<T>& snapshot, ThreadPool& pool) {
+    const size_t n = snapshot.size();
+    std::vector<double> partial((n + kParallelChunk - 1) / kParallelChunk);
+    parallel_chunks(pool, n, kParallelChunk, [&](size_t first, size_t last) {
+        CompensatedSum sum;
+        for (size_t i = first; i < last; ++i) sum.add(snapshot[i]->area());
+        partial[first / kParallelChunk] = sum.value();
+    });
+    return pairwise_sum(partial.data(), partial.size());
+}
@@ -0,0 +1,237 @@
+#pragma once
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include "array.h"
+#include "figure_view.h"
+#include "figures.h"
+#include "store.h"
+
+// Массовый вывод фигур: числа форматируются std::to_chars в один буфер,
+// который уходит в поток большими блоками, без отдельного << на каждую
+// точку. Форматы:
+// - Text: байт в байт как operator<< при настройках потока по умолчанию
+//   (вещественные - как %g с точностью потока, 6 по умолчанию);
+// - Csv: строка "figure,kind,point,x,y" на вершину, с заголовком;
+// - JsonLines: объект {"kind":...,"points":[[x,y],...]} на строку.
+// В Csv и JsonLines вещественные числа пишутся кратчайшей точной записью,
+// inf и nan в JSON - null
+
+enum class OutputFormat {
+    Text,
+    Csv,
+    JsonLines,
+};
+
+// Символьные типы и bool поток выводит не числами, их не поддерживаем
+template<class T>
+concept Serializable = std::is_arithmetic_v<T> && !std::is_same_v<T, bool> && (sizeof(T) > 1 || std::is_floating_point_v<T>);
+
+namespace serializer_detail {
+
+inline const char* kind_name(std::optional<FigureKind> kind) {
+    if (!kind) return "polygon";
+    switch (*kind) {
+    case FigureKind::Rhombus: return "rhombus";
+    case FigureKind::Trapezoid: return "trapezoid";
+    case FigureKind::Pentagon: return "pentagon";
+    }
+    return "polygon";
+}
+
+// Вид фигуры за указателем на базовый класс; Polygon и прочие - nullopt
+template<class T>
+std::optional<FigureKind> kind_of(const Figure<T>& figure) {
+    if (dynamic_cast<const Rhombus<T>*>(&figure)) return FigureKind::Rhombus;
+    if (dynamic_cast<const Trapezoid<T>*>(&figure)) return FigureKind::Trapezoid;
+    if (dynamic_cast<const Pentagon<T>*>(&figure)) return FigureKind::Pentagon;
+    return std::nullopt;
+}
+
+} // namespace serializer_detail
+
+template<Serializable T>
+class FigureWriter {
+public:
+    // Буфер сбрасывается в поток, когда в нём набирается block_bytes
+    explicit FigureWriter(std::ostream& os, OutputFormat format = OutputFormat::Text, size_t block_bytes = size_t(1) << 16)
+        : _os(os), _format(format), _block(block_bytes), _precision(static_cast<int>(os.precision())) {
+        _buffer.reserve(_block + 256);
+        if (_format == OutputFormat::Csv) _buffer += "figure,kind,point,x,y\n";
+    }
+
+    ~FigureWriter() {
+        try {
+            flush();
+        } catch (...) {
+        }
+    }
+
+    FigureWriter(const FigureWriter&) = delete;
+    FigureWriter& operator=(const FigureWriter&) = delete;
+
+    // Через базовый класс: текст как у operator<< для Figure<T>
+    // ("Фигура с", точки с нуля)
+    void write(const Figure<T>& figure) {
+        const auto kind = _format == OutputFormat::Text ? std::nullopt : serializer_detail::kind_of(figure);
+        put(kind, false, figure.vertices());
+    }
+
+    // Ромб, трапеция, пятиугольник: текст как у их operator<<
+    template<class F>
+        requires requires { F::kind; } && std::is_base_of_v<Figure<T>, F>
+    void write(const F& figure) {
+        put(F::kind, true, figure.vertices());
+    }
+
+    void write(const FigureView<T>& view) {
+        put(view.kind(), true, view.vertices());
+    }
+
+    void write(const StoredFigure<T>& figure) {
+        put(figure.kind(), true, PolygonSpan<T>(std::span<const T>(figure.xs(), figure.size()),
+                                                std::span<const T>(figure.ys(), figure.size())));
+    }
+
+    // Вся сцена, как цикл os << *figure
+    void write_all(const Array<std::shared_ptr<Figure<T>>>& figures) {
+        for (const auto& figure : figures) write(*figure);
+    }
+
+    void write_all(const FigureStore<T>& store) {
+        for (size_t i = 0; i < store.size(); ++i) write(store[i]);
+    }
+
+    // Сколько фигур записано
+    size_t count() const noexcept { return _count; }
+
+    void flush() {
+        if (!_buffer.empty()) {
+            _os.write(_buffer.data(), static_cast<std::streamsize>(_buffer.size()));
+            _buffer.clear();
+        }
+        _os.flush();
+    }
+
+private:
+    // kind - вид для Csv/JsonLines; with_kind - текст через write_figure
+    template<class Points>
+    void put(std::optional<FigureKind> kind, bool with_kind, const Points& points) {
+        const size_t n = points.size();
+        switch (_format) {
+        case OutputFormat::Text: {
+            const bool rhombus = with_kind && kind == FigureKind::Rhombus;
+            _buffer += rhombus ? "Ромб с " : "Фигура с ";
+            put_integer(n);
+            _buffer += " точками:\n";
+            for (size_t i = 0; i < n; ++i) {
+                const Point<T> p = points[i];
+                _buffer += "Точка ";
+                put_integer(rhombus ? i + 1 : i);
+                _buffer += ": (";
+                put_text(p.getX());
+                _buffer += ", ";
+                put_text(p.getY());
+                _buffer += ")\n";
+            }
+            break;
+        }
+        case OutputFormat::Csv: {
+            const char* name = serializer_detail::kind_name(kind);
+            for (size_t i = 0; i < n; ++i) {
+                const Point<T> p = points[i];
+                put_integer(_count);
+                _buffer += ',';
+                _buffer += name;
+                _buffer += ',';
+                put_integer(i);
+                _buffer += ',';
+                put_exact(p.getX(), false);
+                _buffer += ',';
+                put_exact(p.getY(), false);
+                _buffer += '\n';
+            }
+            break;
+        }
+        case OutputFormat::JsonLines: {
+            _buffer += "{\"kind\":\"";
+            _buffer += serializer_detail::kind_name(kind);
+            _buffer += "\",\"points\":[";
+            for (size_t i = 0; i < n; ++i) {
+                const Point<T> p = points[i];
+                if (i) _buffer += ',';
+                _buffer += '[';
+                put_exact(p.getX(), true);
+                _buffer += ',';
+                put_exact(p.getY(), true);
+                _buffer += ']';
+            }
+            _buffer += "]}\n";
+            break;
+        }
+        }
+        ++_count;
+        if (_buffer.size() >= _block) {
+            _os.write(_buffer.data(), static_cast<std::streamsize>(_buffer.size()));
+            _buffer.clear();
+        }
+    }
+
+    template<class V>
+    void put_integer(V value) {
+        char digits[24];
+        const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        _buffer.append(digits, result.ptr);
+    }
+
+    // Как ostream с флагами по умолчанию
+    void put_text(T value) {
+        if constexpr (std::is_floating_point_v<T>) {
+            char digits[64];
+            const auto result = std::to_chars(digits, digits + sizeof(digits), value, std::chars_format::general,
+                                              _precision == 0 ? 1 : _precision);
+            _buffer.append(digits, result.ptr);
+        } else {
+            put_integer(value);
+        }
+    }
+
+    // Кратчайшая точная запись; в JSON нет inf и nan
+    void put_exact(T value, bool json) {
+        if constexpr (std::is_floating_point_v<T>) {
+            if (json && !std::isfinite(value)) {
+                _buffer += "null";
+                return;
+            }
+            char digits[64];
+            const auto result = std::to_chars(digits, digits + sizeof(digits), value);
+            _buffer.append(digits, result.ptr);
+        } else {
+            (void)json;
+            put_integer(value);
+        }
+    }
+
+    std::ostream& _os;
+    OutputFormat _format;
+    size_t _block;
+    int _precision;
+    size_t _count = 0;
+    std::string _buffer;
+};
+
+// Запись всей сцены одним вызовом
+template<Serializable T>
+void serialize_figures(std::ostream& os, const Array<std::shared_ptr<Figure<T>>>& figures,
+                       OutputFormat format = OutputFormat::Text) {
+    FigureWriter<T> writer(os, format);
+    writer.write_all(figures);
+    writer.flush();
+}
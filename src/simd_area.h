@@ -0,0 +1,282 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include "store.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SMARTLAB_X86_SIMD 1
+#endif
+
+// Пакетное вычисление площадей фигур из FigureStore.
+// Фигуры одного числа вершин, идущие подряд, лежат в xs/ys с постоянным
+// шагом, поэтому за одну инструкцию считаем сразу несколько фигур:
+// AVX2 - 4 фигуры, SSE2 - 2 фигуры. Координаты читаются целыми векторами
+// подряд и переставляются по вершинам в регистрах. Порядок операций тот
+// же, что в shoelace_area, так что результат совпадает со скалярным.
+// Замеры - BM_Areas в bench/bench_figure.cpp.
+// Векторные ядра есть для int32_t, float и double, остальные типы считаются
+// скалярно
+
+enum class SimdLevel {
+    Scalar,
+    SSE2,
+    AVX2,
+};
+
+// Лучший доступный набор инструкций, определяется один раз при запуске
+inline SimdLevel detect_simd_level() {
+#ifdef SMARTLAB_X86_SIMD
+    static const SimdLevel level = [] {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+        if (__builtin_cpu_supports("sse2")) return SimdLevel::SSE2;
+        return SimdLevel::Scalar;
+    }();
+    return level;
+#else
+    return SimdLevel::Scalar;
+#endif
+}
+
+namespace simd_detail {
+
+// count фигур по N вершин, i-я фигура начинается с xs[i * N]
+template<size_t N, class T>
+void areas_scalar(const T* xs, const T* ys, size_t count, double* out) {
+    for (size_t f = 0; f < count; ++f) {
+        const T* fx = xs + f * N;
+        const T* fy = ys + f * N;
+        out[f] = shoelace_area(N, [&](size_t i) { return Point<T>(fx[i], fy[i]); });
+    }
+}
+
+template<class T>
+constexpr bool has_simd_kernel =
+    std::is_same_v<T, double> || std::is_same_v<T, float> || std::is_same_v<T, int32_t>;
+
+#ifdef SMARTLAB_X86_SIMD
+
+// Две соседние координаты p[0], p[1] в double; float и int32_t
+// переводятся прямо при загрузке (точно)
+template<class T>
+__attribute__((target("sse2"))) inline __m128d load_pair(const T* p) {
+    if constexpr (std::is_same_v<T, double>) {
+        return _mm_loadu_pd(p);
+    } else if constexpr (std::is_same_v<T, float>) {
+        return _mm_cvtps_pd(_mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(p))));
+    } else {
+        return _mm_cvtepi32_pd(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)));
+    }
+}
+
+// Вершины двух фигур, лежащих подряд по N координат, в векторы по
+// вершинам: v[i] = (f0[i], f1[i]). Загрузки - целыми парами соседних
+// вершин, перестановка - в регистрах, без поэлементной сборки
+template<size_t N, class T>
+__attribute__((target("sse2"))) inline void transpose2(const T* p, __m128d* v) {
+    for (size_t i = 0; i + 1 < N; i += 2) {
+        const __m128d a = load_pair(p + i);
+        const __m128d b = load_pair(p + N + i);
+        v[i] = _mm_unpacklo_pd(a, b);
+        v[i + 1] = _mm_unpackhi_pd(a, b);
+    }
+    if constexpr (N % 2 == 1) {
+        v[N - 1] = _mm_unpackhi_pd(load_pair(p + N - 2), load_pair(p + 2 * N - 2));
+    }
+}
+
+// То же для четырёх фигур: в a пары вершин фигур 0 и 2, в b - фигур 1 и 3,
+// поэтому unpacklo/unpackhi сразу дают (f0, f1, f2, f3)[i]
+template<class T>
+__attribute__((target("avx2"))) inline __m256d load_pairs(const T* low, const T* high) {
+    return _mm256_insertf128_pd(_mm256_castpd128_pd256(load_pair(low)), load_pair(high), 1);
+}
+
+template<size_t N, class T>
+__attribute__((target("avx2"))) inline void transpose4(const T* p, __m256d* v) {
+    for (size_t i = 0; i + 1 < N; i += 2) {
+        const __m256d a = load_pairs(p + i, p + 2 * N + i);
+        const __m256d b = load_pairs(p + N + i, p + 3 * N + i);
+        v[i] = _mm256_unpacklo_pd(a, b);
+        v[i + 1] = _mm256_unpackhi_pd(a, b);
+    }
+    if constexpr (N % 2 == 1) {
+        const __m256d a = load_pairs(p + N - 2, p + 3 * N - 2);
+        const __m256d b = load_pairs(p + 2 * N - 2, p + 4 * N - 2);
+        v[N - 1] = _mm256_unpackhi_pd(a, b);
+    }
+}
+
+template<size_t N, class T>
+__attribute__((target("sse2"))) void areas_sse2(const T* xs, const T* ys, size_t count, double* out) {
+    const __m128d sign = _mm_set1_pd(-0.0);
+    const __m128d half = _mm_set1_pd(0.5);
+    size_t f = 0;
+    for (; f + 2 <= count; f += 2) {
+        __m128d x[N], y[N];
+        transpose2<N>(xs + f * N, x);
+        transpose2<N>(ys + f * N, y);
+        __m128d sum = _mm_setzero_pd();
+        for (size_t i = 0; i < N; ++i) {
+            const size_t j = (i + 1) % N;
+            sum = _mm_add_pd(sum, _mm_sub_pd(_mm_mul_pd(x[i], y[j]), _mm_mul_pd(x[j], y[i])));
+        }
+        _mm_storeu_pd(out + f, _mm_mul_pd(_mm_andnot_pd(sign, sum), half));
+    }
+    areas_scalar<N>(xs + f * N, ys + f * N, count - f, out + f);
+}
+
+// 32-битные координаты четырёх фигур (N = 4 или 5): сначала перестановка
+// целыми 32-битными словами, затем перевод в double по 4 числа за раз.
+// Фигуры в векторах идут в порядке 0, 2, 1, 3
+template<class T>
+__attribute__((target("avx2"))) inline __m256d to_pd(__m128 v) {
+    if constexpr (std::is_same_v<T, float>) return _mm256_cvtps_pd(v);
+    else return _mm256_cvtepi32_pd(_mm_castps_si128(v));
+}
+
+template<size_t N, class T>
+__attribute__((target("avx2"))) inline __m256 load_rows(const T* p, size_t first) {
+    // Вершины first..first+3 фигур 0 и 1 (a) или 2 и 3 (b)
+    const float* f = reinterpret_cast<const float*>(p);
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(f + first)), _mm_loadu_ps(f + N + first), 1);
+}
+
+template<size_t N, class T>
+__attribute__((target("avx2"))) inline void transpose4_32(const T* p, __m256d* v) {
+    static_assert(N == 4 || N == 5);
+    const __m256 a = load_rows<N>(p, 0);
+    const __m256 b = load_rows<N>(p + 2 * N, 0);
+    // (f0 f2 f0 f2 | f1 f3 f1 f3) по вершинам 0,0,1,1 и 2,2,3,3; vpermpd
+    // собирает в младшей половине вершину 0 (2), в старшей - 1 (3)
+    const __m256d lo = _mm256_permute4x64_pd(_mm256_castps_pd(_mm256_unpacklo_ps(a, b)), 0xd8);
+    const __m256d hi = _mm256_permute4x64_pd(_mm256_castps_pd(_mm256_unpackhi_ps(a, b)), 0xd8);
+    v[0] = to_pd<T>(_mm256_castps256_ps128(_mm256_castpd_ps(lo)));
+    v[1] = to_pd<T>(_mm256_extractf128_ps(_mm256_castpd_ps(lo), 1));
+    v[2] = to_pd<T>(_mm256_castps256_ps128(_mm256_castpd_ps(hi)));
+    v[3] = to_pd<T>(_mm256_extractf128_ps(_mm256_castpd_ps(hi), 1));
+    if constexpr (N == 5) {
+        const __m256 c = load_rows<N>(p, 1);
+        const __m256 d = load_rows<N>(p + 2 * N, 1);
+        const __m256d tail = _mm256_permute4x64_pd(_mm256_castps_pd(_mm256_unpackhi_ps(c, d)), 0xd8);
+        v[4] = to_pd<T>(_mm256_extractf128_ps(_mm256_castpd_ps(tail), 1));
+    }
+}
+
+template<size_t N, class T>
+__attribute__((target("avx2"))) void areas_avx2(const T* xs, const T* ys, size_t count, double* out) {
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    const __m256d half = _mm256_set1_pd(0.5);
+    size_t f = 0;
+    for (; f + 4 <= count; f += 4) {
+        __m256d x[N], y[N];
+        if constexpr (std::is_same_v<T, double>) {
+            transpose4<N>(xs + f * N, x);
+            transpose4<N>(ys + f * N, y);
+        } else {
+            transpose4_32<N>(xs + f * N, x);
+            transpose4_32<N>(ys + f * N, y);
+        }
+        __m256d sum = _mm256_setzero_pd();
+        for (size_t i = 0; i < N; ++i) {
+            const size_t j = (i + 1) % N;
+            sum = _mm256_add_pd(sum, _mm256_sub_pd(_mm256_mul_pd(x[i], y[j]), _mm256_mul_pd(x[j], y[i])));
+        }
+        __m256d result = _mm256_mul_pd(_mm256_andnot_pd(sign, sum), half);
+        if constexpr (!std::is_same_v<T, double>) result = _mm256_permute4x64_pd(result, 0xd8);
+        _mm256_storeu_pd(out + f, result);
+    }
+    areas_sse2<N>(xs + f * N, ys + f * N, count - f, out + f);
+}
+
+#endif
+
+// Конец участка фигур с тем же числом вершин n, что и у фигуры first.
+// Вершин у фигур только 4 или 5, поэтому offsets[k] - offsets[first] ==
+// (k - first) * n ровно тогда, когда все фигуры [first, k) - по n вершин.
+// Условие монотонно, и границу ищем галопом и делением пополам, а не
+// проходом по всем фигурам
+inline size_t same_arity_end(std::span<const size_t> offsets, size_t first, size_t n) {
+    const size_t size = offsets.size() - 1;
+    auto same = [&](size_t k) { return offsets[k] - offsets[first] == (k - first) * n; };
+    // same(lo) верно; same(hi) неверно или hi == size + 1
+    size_t lo = first + 1, hi = lo;
+    for (size_t step = 1;; step *= 2) {
+        hi = lo + step;
+        if (hi > size) {
+            hi = size + 1;
+            break;
+        }
+        if (!same(hi)) break;
+        lo = hi;
+    }
+    while (hi - lo > 1) {
+        const size_t mid = lo + (hi - lo) / 2;
+        if (same(mid)) lo = mid;
+        else hi = mid;
+    }
+    return lo;
+}
+
+template<size_t N, class T>
+void areas_run(SimdLevel level, const T* xs, const T* ys, size_t count, double* out) {
+#ifdef SMARTLAB_X86_SIMD
+    if constexpr (has_simd_kernel<T>) {
+        if (level == SimdLevel::AVX2) return areas_avx2<N>(xs, ys, count, out);
+        if (level == SimdLevel::SSE2) return areas_sse2<N>(xs, ys, count, out);
+    }
+#endif
+    (void)level;
+    areas_scalar<N>(xs, ys, count, out);
+}
+
+} // namespace simd_detail
+
+// Площади всех фигур хранилища, out.size() должен быть равен store.size()
+template<Pointable T>
+void areas(const FigureStore<T>& store, std::span<double> out, SimdLevel level = detect_simd_level()) {
+    if (out.size() != store.size()) throw std::invalid_argument("Output size does not match store size");
+    const auto offsets = store.offsets();
+    const T* xs = store.xs().data();
+    const T* ys = store.ys().data();
+
+    // Разбиваем хранилище на участки фигур с одинаковым числом вершин
+    size_t first = 0;
+    while (first < store.size()) {
+        const size_t n = offsets[first + 1] - offsets[first];
+        const size_t last = simd_detail::same_arity_end(offsets, first, n);
+
+        const size_t base = offsets[first];
+        if (n == 4) {
+            simd_detail::areas_run<4>(level, xs + base, ys + base, last - first, out.data() + first);
+        } else if (n == 5) {
+            simd_detail::areas_run<5>(level, xs + base, ys + base, last - first, out.data() + first);
+        } else {
+            for (size_t i = first; i < last; ++i) out[i] = store[i].area();
+        }
+        first = last;
+    }
+}
+
+template<Pointable T>
+std::vector<double> areas(const FigureStore<T>& store, SimdLevel level = detect_simd_level()) {
+    std::vector<double> out(store.size());
+    areas(store, std::span<double>(out), level);
+    return out;
+}
+
+// Сумма площадей; складываем в том же порядке, что и FigureStore::total_area
+template<Pointable T>
+double simd_total_area(const FigureStore<T>& store, SimdLevel level = detect_simd_level()) {
+    const std::vector<double> values = areas(store, level);
+    double total = 0;
+    for (double a : values) total += a;
+    return total;
+}
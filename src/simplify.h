@@ -0,0 +1,259 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <queue>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "figures.h"
+#include "parallel.h"
+
+// Выпуклая оболочка и упрощение контуров с большим числом вершин.
+// Результат - новая фигура Polygon<T> из исходных вершин (новых точек
+// не появляется, поэтому тип координат сохраняется)
+
+// С какого числа точек сортировка для оболочки идёт параллельно
+inline constexpr size_t kParallelSortMin = 1 << 15;
+
+namespace simplify_detail {
+
+using geometry_detail::int128_t;
+
+// Знак векторного произведения (a - o) x (b - o); для целых координат точно
+template<class T>
+int orientation(const Point<T>& o, const Point<T>& a, const Point<T>& b) {
+    if constexpr (std::is_integral_v<T>) {
+        const int128_t v = (static_cast<int128_t>(a.getX()) - o.getX()) * (static_cast<int128_t>(b.getY()) - o.getY()) -
+                           (static_cast<int128_t>(a.getY()) - o.getY()) * (static_cast<int128_t>(b.getX()) - o.getX());
+        return (v > 0) - (v < 0);
+    } else {
+        const double v = (static_cast<double>(a.getX()) - o.getX()) * (static_cast<double>(b.getY()) - o.getY()) -
+                         (static_cast<double>(a.getY()) - o.getY()) * (static_cast<double>(b.getX()) - o.getX());
+        return (v > 0) - (v < 0);
+    }
+}
+
+template<class T>
+bool point_less(const Point<T>& a, const Point<T>& b) {
+    return a.getX() < b.getX() || (a.getX() == b.getX() && a.getY() < b.getY());
+}
+
+template<class T>
+bool point_equal(const Point<T>& a, const Point<T>& b) {
+    return a.getX() == b.getX() && a.getY() == b.getY();
+}
+
+// Куски сортируются в пуле, затем попарно сливаются, уровень за уровнем
+template<class T>
+void parallel_sort(std::vector<Point<T>>& points, ThreadPool& pool) {
+    const size_t n = points.size();
+    const size_t chunk = (n + pool.size() - 1) / pool.size();
+    auto less = [](const Point<T>& a, const Point<T>& b) { return point_less(a, b); };
+    parallel_chunks(pool, n, chunk, [&](size_t first, size_t last) {
+        std::sort(points.begin() + first, points.begin() + last, less);
+    });
+    for (size_t width = chunk; width < n; width *= 2) {
+        for (size_t first = 0; first + width < n; first += 2 * width) {
+            const size_t mid = first + width, last = std::min(n, first + 2 * width);
+            pool.submit([&points, first, mid, last, less] {
+                std::inplace_merge(points.begin() + first, points.begin() + mid, points.begin() + last, less);
+            });
+        }
+        pool.wait();
+    }
+}
+
+// Расстояние от p до отрезка a-b
+template<class T>
+double segment_distance(const Point<T>& p, const Point<T>& a, const Point<T>& b) {
+    const double ax = a.getX(), ay = a.getY();
+    const double dx = static_cast<double>(b.getX()) - ax, dy = static_cast<double>(b.getY()) - ay;
+    const double px = static_cast<double>(p.getX()) - ax, py = static_cast<double>(p.getY()) - ay;
+    const double len2 = dx * dx + dy * dy;
+    double t = len2 > 0 ? (px * dx + py * dy) / len2 : 0.0;
+    t = std::clamp(t, 0.0, 1.0);
+    return std::hypot(px - t * dx, py - t * dy);
+}
+
+template<class T>
+double triangle_area(const Point<T>& a, const Point<T>& b, const Point<T>& c) {
+    const double v = (static_cast<double>(b.getX()) - a.getX()) * (static_cast<double>(c.getY()) - a.getY()) -
+                     (static_cast<double>(b.getY()) - a.getY()) * (static_cast<double>(c.getX()) - a.getX());
+    return std::abs(v) * 0.5;
+}
+
+template<class T>
+Polygon<T> polygon_of(std::span<const Point<T>> points, const std::vector<uint8_t>& keep) {
+    Polygon<T> polygon;
+    size_t count = 0;
+    for (uint8_t k : keep) count += k;
+    std::vector<Point<T>> kept;
+    kept.reserve(count);
+    for (size_t i = 0; i < points.size(); ++i) {
+        if (keep[i]) kept.push_back(points[i]);
+    }
+    polygon.add_points(kept);
+    return polygon;
+}
+
+} // namespace simplify_detail
+
+// Выпуклая оболочка (монотонная цепочка Эндрю), O(n log n). Вершины против
+// часовой стрелки, без точек на сторонах. Для больших наборов сортировка
+// идёт параллельно в threads потоках (0 - по числу ядер, 1 - без потоков)
+template<class T>
+Polygon<T> convex_hull(std::span<const Point<T>> points, size_t threads = 0) {
+    using namespace simplify_detail;
+    std::vector<Point<T>> sorted(points.begin(), points.end());
+    if (sorted.size() >= kParallelSortMin && threads != 1) {
+        ThreadPool pool(threads);
+        parallel_sort(sorted, pool);
+    } else {
+        std::sort(sorted.begin(), sorted.end(), [](const Point<T>& a, const Point<T>& b) { return point_less(a, b); });
+    }
+    sorted.erase(std::unique(sorted.begin(), sorted.end(), [](const Point<T>& a, const Point<T>& b) { return point_equal(a, b); }),
+                 sorted.end());
+
+    Polygon<T> hull;
+    const size_t n = sorted.size();
+    if (n < 3) {
+        hull.add_points(sorted);
+        return hull;
+    }
+    std::vector<Point<T>> chain(2 * n);
+    size_t k = 0;
+    for (size_t i = 0; i < n; ++i) {
+        while (k >= 2 && orientation(chain[k - 2], chain[k - 1], sorted[i]) <= 0) --k;
+        chain[k++] = sorted[i];
+    }
+    for (size_t i = n - 1, lower = k + 1; i-- > 0;) {
+        while (k >= lower && orientation(chain[k - 2], chain[k - 1], sorted[i]) <= 0) --k;
+        chain[k++] = sorted[i];
+    }
+    chain.resize(k - 1);
+    hull.add_points(chain);
+    return hull;
+}
+
+template<class T>
+Polygon<T> convex_hull(const Figure<T>& figure, size_t threads = 0) {
+    return convex_hull(figure.vertices(), threads);
+}
+
+// Упрощение замкнутого контура алгоритмом Рамера-Дугласа-Пекера: остаются
+// вершины, отстоящие от упрощённого контура больше чем на tolerance.
+// Стек вместо рекурсии, чтобы не упереться в глубину на 100k+ точках
+template<class T>
+Polygon<T> simplify_rdp(std::span<const Point<T>> points, double tolerance) {
+    using namespace simplify_detail;
+    const size_t n = points.size();
+    std::vector<uint8_t> keep(n, n <= 3 ? 1 : 0);
+    if (n <= 3) return polygon_of(points, keep);
+
+    // Две опорные вершины: первая и самая далёкая от неё
+    size_t far = 0;
+    double far_d = -1;
+    for (size_t i = 1; i < n; ++i) {
+        const double d = segment_distance(points[i], points[0], points[0]);
+        if (d > far_d) {
+            far_d = d;
+            far = i;
+        }
+    }
+    keep[0] = keep[far] = 1;
+
+    // Отрезки [i, j] в "развёрнутой" нумерации, вершина - index % n
+    std::vector<std::pair<size_t, size_t>> stack = {{0, far}, {far, n}};
+    while (!stack.empty()) {
+        const auto [i, j] = stack.back();
+        stack.pop_back();
+        double best = -1;
+        size_t best_k = i;
+        for (size_t k = i + 1; k < j; ++k) {
+            const double d = segment_distance(points[k % n], points[i % n], points[j % n]);
+            if (d > best) {
+                best = d;
+                best_k = k;
+            }
+        }
+        if (best > tolerance) {
+            keep[best_k % n] = 1;
+            stack.emplace_back(i, best_k);
+            stack.emplace_back(best_k, j);
+        }
+    }
+
+    // Меньше трёх вершин - не многоугольник; добавляем самую далёкую от
+    // отрезка между опорными вершинами
+    if (std::count(keep.begin(), keep.end(), 1) < 3) {
+        double best = -1;
+        size_t best_k = 0;
+        for (size_t k = 0; k < n; ++k) {
+            if (keep[k]) continue;
+            const double d = segment_distance(points[k], points[0], points[far]);
+            if (d > best) {
+                best = d;
+                best_k = k;
+            }
+        }
+        keep[best_k] = 1;
+    }
+    return polygon_of(points, keep);
+}
+
+template<class T>
+Polygon<T> simplify_rdp(const Figure<T>& figure, double tolerance) {
+    return simplify_rdp(figure.vertices(), tolerance);
+}
+
+// Упрощение Висвалингам-Уайетта: по одной удаляются вершины с наименьшей
+// площадью треугольника с соседями, пока она меньше min_area. Остаётся не
+// меньше трёх вершин. O(n log n) с кучей и ленивым удалением
+template<class T>
+Polygon<T> simplify_visvalingam(std::span<const Point<T>> points, double min_area) {
+    using namespace simplify_detail;
+    const size_t n = points.size();
+    std::vector<uint8_t> keep(n, 1);
+    if (n <= 3) return polygon_of(points, keep);
+
+    std::vector<size_t> prev(n), next(n);
+    std::vector<double> area(n);
+    for (size_t i = 0; i < n; ++i) {
+        prev[i] = (i + n - 1) % n;
+        next[i] = (i + 1) % n;
+        area[i] = triangle_area(points[prev[i]], points[i], points[next[i]]);
+    }
+
+    using Entry = std::pair<double, size_t>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap;
+    for (size_t i = 0; i < n; ++i) heap.emplace(area[i], i);
+
+    size_t remaining = n;
+    while (!heap.empty() && remaining > 3) {
+        const auto [a, i] = heap.top();
+        heap.pop();
+        // Устаревшая запись: вершина удалена или её площадь пересчитана
+        if (!keep[i] || a != area[i]) continue;
+        if (a >= min_area) break;
+        keep[i] = 0;
+        --remaining;
+        const size_t p = prev[i], q = next[i];
+        next[p] = q;
+        prev[q] = p;
+        // Площадь соседа не меньше удалённой, иначе порядок удаления
+        // зависел бы от уже удалённых мелких деталей
+        for (size_t v : {p, q}) {
+            area[v] = std::max(a, triangle_area(points[prev[v]], points[v], points[next[v]]));
+            heap.emplace(area[v], v);
+        }
+    }
+    return polygon_of(points, keep);
+}
+
+template<class T>
+Polygon<T> simplify_visvalingam(const Figure<T>& figure, double min_area) {
+    return simplify_visvalingam(figure.vertices(), min_area);
+}
@@ -0,0 +1,342 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+#include <vector>
+#include "array.h"
+#include "base.h"
+
+// Пространственные индексы по коллекции фигур: R-дерево, упакованное
+// методом STR (Sort-Tile-Recursive), и равномерная сетка.
+// Индекс хранит номера фигур в исходном массиве и их габариты, сами фигуры
+// не копируются; после изменения коллекции индекс нужно построить заново
+
+namespace spatial_detail {
+
+struct Box {
+    double min_x = std::numeric_limits<double>::infinity();
+    double min_y = std::numeric_limits<double>::infinity();
+    double max_x = -std::numeric_limits<double>::infinity();
+    double max_y = -std::numeric_limits<double>::infinity();
+
+    void expand(const Box& b) {
+        min_x = std::min(min_x, b.min_x);
+        min_y = std::min(min_y, b.min_y);
+        max_x = std::max(max_x, b.max_x);
+        max_y = std::max(max_y, b.max_y);
+    }
+
+    void expand(double x, double y) {
+        min_x = std::min(min_x, x);
+        min_y = std::min(min_y, y);
+        max_x = std::max(max_x, x);
+        max_y = std::max(max_y, y);
+    }
+
+    bool intersects(const Box& b) const {
+        return min_x <= b.max_x && b.min_x <= max_x && min_y <= b.max_y && b.min_y <= max_y;
+    }
+
+    bool contains(double x, double y) const {
+        return x >= min_x && x <= max_x && y >= min_y && y <= max_y;
+    }
+
+    // Квадрат расстояния от точки до прямоугольника
+    double distance2(double x, double y) const {
+        const double dx = std::max({min_x - x, 0.0, x - max_x});
+        const double dy = std::max({min_y - y, 0.0, y - max_y});
+        return dx * dx + dy * dy;
+    }
+
+    double center_x() const { return (min_x + max_x) * 0.5; }
+    double center_y() const { return (min_y + max_y) * 0.5; }
+
+    template<class T>
+    static Box from(const Bounds<T>& b) {
+        return Box{static_cast<double>(b.min_x), static_cast<double>(b.min_y),
+                   static_cast<double>(b.max_x), static_cast<double>(b.max_y)};
+    }
+};
+
+} // namespace spatial_detail
+
+template<class T>
+class RTree {
+public:
+    // Построение по фигурам: габарит каждой фигуры из bounds(), центр из center()
+    explicit RTree(const Array<std::shared_ptr<Figure<T>>>& figures, size_t node_capacity = 16)
+        : _capacity(std::max<size_t>(node_capacity, 2)) {
+        _entries.reserve(figures.size());
+        for (size_t i = 0; i < figures.size(); ++i) {
+            const Figure<T>& f = *figures[i];
+            const Point<T> c = f.center();
+            Entry e;
+            e.box = spatial_detail::Box::from(f.bounds());
+            e.cx = static_cast<double>(c.getX());
+            e.cy = static_cast<double>(c.getY());
+            e.id = i;
+            _entries.push_back(e);
+        }
+        build();
+    }
+
+    size_t size() const noexcept { return _entries.size(); }
+
+    // Все фигуры, габарит которых пересекает окно
+    template<class Visit>
+    void query(const Bounds<T>& window, Visit&& visit) const {
+        const auto w = spatial_detail::Box::from(window);
+        search([&](const spatial_detail::Box& b) { return b.intersects(w); },
+               [&](const Entry& e) { if (e.box.intersects(w)) visit(e.id); });
+    }
+
+    std::vector<size_t> query(const Bounds<T>& window) const {
+        std::vector<size_t> out;
+        query(window, [&](size_t id) { out.push_back(id); });
+        return out;
+    }
+
+    // Кандидаты для проверки "точка внутри фигуры": фигуры, в габарит
+    // которых попадает точка
+    std::vector<size_t> candidates(const Point<T>& p) const {
+        const double x = static_cast<double>(p.getX());
+        const double y = static_cast<double>(p.getY());
+        std::vector<size_t> out;
+        search([&](const spatial_detail::Box& b) { return b.contains(x, y); },
+               [&](const Entry& e) { if (e.box.contains(x, y)) out.push_back(e.id); });
+        return out;
+    }
+
+    // k фигур с ближайшими к p центрами, по возрастанию расстояния
+    std::vector<size_t> nearest(const Point<T>& p, size_t k) const {
+        std::vector<size_t> out;
+        if (_nodes.empty() || k == 0) return out;
+        const double x = static_cast<double>(p.getX());
+        const double y = static_cast<double>(p.getY());
+
+        // Обход по возрастанию нижней оценки расстояния: узлы оцениваются
+        // расстоянием до прямоугольника, фигуры - точным расстоянием до центра
+        struct Item {
+            double d2;
+            bool is_entry;
+            size_t index;
+            bool operator>(const Item& o) const { return d2 > o.d2 || (d2 == o.d2 && index > o.index); }
+        };
+        std::priority_queue<Item, std::vector<Item>, std::greater<Item>> heap;
+        heap.push({_nodes[_root].box.distance2(x, y), false, _root});
+        while (!heap.empty() && out.size() < k) {
+            const Item item = heap.top();
+            heap.pop();
+            if (item.is_entry) {
+                out.push_back(_entries[item.index].id);
+                continue;
+            }
+            const Node& node = _nodes[item.index];
+            for (size_t c = node.first; c < node.first + node.count; ++c) {
+                if (node.leaf) {
+                    const Entry& e = _entries[c];
+                    const double dx = e.cx - x, dy = e.cy - y;
+                    heap.push({dx * dx + dy * dy, true, c});
+                } else {
+                    heap.push({_nodes[c].box.distance2(x, y), false, c});
+                }
+            }
+        }
+        return out;
+    }
+
+private:
+    struct Entry {
+        spatial_detail::Box box;
+        double cx, cy;
+        size_t id;
+    };
+
+    struct Node {
+        spatial_detail::Box box;
+        size_t first;   // первый ребёнок: индекс в _entries для листа, в _nodes иначе
+        size_t count;
+        bool leaf;
+    };
+
+    // Упаковка STR: сортируем по x, режем на вертикальные полосы, внутри
+    // полосы сортируем по y и набиваем узлы по _capacity элементов
+    template<class Item, class GetBox>
+    void str_sort(std::vector<Item>& items, GetBox box_of) const {
+        const size_t n = items.size();
+        const size_t pages = (n + _capacity - 1) / _capacity;
+        const size_t slabs = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(pages))));
+        const size_t per_slab = slabs * _capacity;
+        std::sort(items.begin(), items.end(), [&](const Item& a, const Item& b) {
+            return box_of(a).center_x() < box_of(b).center_x();
+        });
+        for (size_t first = 0; first < n; first += per_slab) {
+            const auto last = items.begin() + static_cast<std::ptrdiff_t>(std::min(n, first + per_slab));
+            std::sort(items.begin() + static_cast<std::ptrdiff_t>(first), last, [&](const Item& a, const Item& b) {
+                return box_of(a).center_y() < box_of(b).center_y();
+            });
+        }
+    }
+
+    void build() {
+        if (_entries.empty()) return;
+        // В габарит узла включаем и центры фигур, чтобы оценка для поиска
+        // ближайших была нижней границей
+        auto entry_box = [](const Entry& e) {
+            spatial_detail::Box b = e.box;
+            b.expand(e.cx, e.cy);
+            return b;
+        };
+        str_sort(_entries, [](const Entry& e) { return e.box; });
+
+        std::vector<Node> level;
+        for (size_t first = 0; first < _entries.size(); first += _capacity) {
+            Node node{{}, first, std::min(_capacity, _entries.size() - first), true};
+            for (size_t i = first; i < first + node.count; ++i) node.box.expand(entry_box(_entries[i]));
+            level.push_back(node);
+        }
+
+        // Уровни кладём в _nodes снизу вверх, корень - последний узел
+        while (level.size() > 1) {
+            str_sort(level, [](const Node& n) { return n.box; });
+            const size_t base = _nodes.size();
+            _nodes.insert(_nodes.end(), level.begin(), level.end());
+            std::vector<Node> parents;
+            for (size_t first = 0; first < level.size(); first += _capacity) {
+                Node node{{}, base + first, std::min(_capacity, level.size() - first), false};
+                for (size_t i = first; i < first + node.count; ++i) node.box.expand(level[i].box);
+                parents.push_back(node);
+            }
+            level = std::move(parents);
+        }
+        _nodes.push_back(level.front());
+        _root = _nodes.size() - 1;
+    }
+
+    template<class NodeTest, class EntryVisit>
+    void search(NodeTest&& test, EntryVisit&& visit) const {
+        if (_nodes.empty()) return;
+        std::vector<size_t> stack{_root};
+        while (!stack.empty()) {
+            const Node& node = _nodes[stack.back()];
+            stack.pop_back();
+            if (!test(node.box)) continue;
+            for (size_t c = node.first; c < node.first + node.count; ++c) {
+                if (node.leaf) visit(_entries[c]);
+                else stack.push_back(c);
+            }
+        }
+    }
+
+    size_t _capacity;
+    std::vector<Entry> _entries;
+    std::vector<Node> _nodes;
+    size_t _root = 0;
+};
+
+// Равномерная сетка: каждая фигура записана во все клетки, которые
+// пересекает её габарит. Хорошо подходит для фигур примерно одного размера
+template<class T>
+class UniformGrid {
+public:
+    UniformGrid(const Array<std::shared_ptr<Figure<T>>>& figures, double cell_size) : _cell(cell_size) {
+        if (!(cell_size > 0)) throw std::invalid_argument("Grid cell size must be positive");
+        _boxes.reserve(figures.size());
+        for (size_t i = 0; i < figures.size(); ++i) {
+            _boxes.push_back(spatial_detail::Box::from(figures[i]->bounds()));
+            _extent.expand(_boxes.back());
+        }
+        if (_boxes.empty()) return;
+        // Считаем в double, чтобы мелкая клетка не переполнила size_t
+        const double cols = std::floor((_extent.max_x - _extent.min_x) / _cell) + 1;
+        const double rows = std::floor((_extent.max_y - _extent.min_y) / _cell) + 1;
+        if (!(cols * rows <= static_cast<double>(kMaxCells))) {
+            throw std::invalid_argument("Grid cell size is too small for the figures extent");
+        }
+        _cols = static_cast<size_t>(cols);
+        _rows = static_cast<size_t>(rows);
+
+        // Раскладка в CSR: сначала считаем, сколько фигур в каждой клетке
+        _start.assign(_cols * _rows + 1, 0);
+        for (const auto& b : _boxes) for_cells(b, [&](size_t cell) { ++_start[cell + 1]; });
+        for (size_t c = 1; c < _start.size(); ++c) _start[c] += _start[c - 1];
+        _items.resize(_start.back());
+        std::vector<size_t> fill(_start.begin(), _start.end() - 1);
+        for (size_t i = 0; i < _boxes.size(); ++i) {
+            for_cells(_boxes[i], [&](size_t cell) { _items[fill[cell]++] = i; });
+        }
+    }
+
+    size_t size() const noexcept { return _boxes.size(); }
+
+    std::vector<size_t> query(const Bounds<T>& window) const {
+        std::vector<size_t> out;
+        if (_boxes.empty()) return out;
+        const auto w = spatial_detail::Box::from(window);
+        if (!w.intersects(_extent)) return out;
+        // Фигура может лежать в нескольких клетках: выдаём её только из той,
+        // где лежит левый нижний угол её габарита, обрезанного по окну
+        for_cells(w, [&](size_t cell) {
+            for (size_t k = _start[cell]; k < _start[cell + 1]; ++k) {
+                const size_t id = _items[k];
+                const auto& b = _boxes[id];
+                if (b.intersects(w) && cell_of(std::max(b.min_x, w.min_x), std::max(b.min_y, w.min_y)) == cell) {
+                    out.push_back(id);
+                }
+            }
+        });
+        std::sort(out.begin(), out.end());
+        return out;
+    }
+
+    std::vector<size_t> candidates(const Point<T>& p) const {
+        std::vector<size_t> out;
+        const double x = static_cast<double>(p.getX());
+        const double y = static_cast<double>(p.getY());
+        if (_boxes.empty() || !_extent.contains(x, y)) return out;
+        const size_t cell = cell_index(y, _extent.min_y) * _cols + cell_index(x, _extent.min_x);
+        for (size_t k = _start[cell]; k < _start[cell + 1]; ++k) {
+            if (_boxes[_items[k]].contains(x, y)) out.push_back(_items[k]);
+        }
+        return out;
+    }
+
+private:
+    // Больше клеток сетка не заводит: CSR на них уже занимает 512 МБ
+    static constexpr size_t kMaxCells = size_t(1) << 26;
+
+    size_t cell_index(double v, double origin) const {
+        return static_cast<size_t>(std::floor((v - origin) / _cell));
+    }
+
+    // Клетка точки внутри габарита сцены, с тем же обрезанием, что в for_cells
+    size_t cell_of(double x, double y) const {
+        const size_t c = std::min(_cols - 1, cell_index(x, _extent.min_x));
+        const size_t r = std::min(_rows - 1, cell_index(y, _extent.min_y));
+        return r * _cols + c;
+    }
+
+    // Обход клеток, пересекающих прямоугольник (обрезанный по сетке)
+    template<class Visit>
+    void for_cells(const spatial_detail::Box& b, Visit&& visit) const {
+        const size_t c0 = cell_index(std::max(b.min_x, _extent.min_x), _extent.min_x);
+        const size_t r0 = cell_index(std::max(b.min_y, _extent.min_y), _extent.min_y);
+        const size_t c1 = std::min(_cols - 1, cell_index(std::min(b.max_x, _extent.max_x), _extent.min_x));
+        const size_t r1 = std::min(_rows - 1, cell_index(std::min(b.max_y, _extent.max_y), _extent.min_y));
+        for (size_t r = r0; r <= r1; ++r) {
+            for (size_t c = c0; c <= c1; ++c) visit(r * _cols + c);
+        }
+    }
+
+    double _cell;
+    spatial_detail::Box _extent;
+    std::vector<spatial_detail::Box> _boxes;
+    size_t _cols = 0;
+    size_t _rows = 0;
+    std::vector<size_t> _start;
+    std::vector<size_t> _items;
+};
@@ -0,0 +1,147 @@
+#pragma once
+#include <cstddef>
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <vector>
+#include "geometry.h"
+#include "point.h"
+
+// Лёгкое представление одной фигуры из FigureStore: вид, число вершин и
+// указатели на её координаты. Ничем не владеет
+template<Pointable T>
+class StoredFigure {
+public:
+    StoredFigure(FigureKind kind, size_t n, const T* xs, const T* ys)
+        : _kind(kind), _n(n), _xs(xs), _ys(ys) {}
+
+    FigureKind kind() const { return _kind; }
+    size_t size() const { return _n; }
+    const T* xs() const { return _xs; }
+    const T* ys() const { return _ys; }
+
+    Point<T> point(size_t i) const {
+        if (i >= _n) throw std::out_of_range("Index out of range");
+        return Point<T>(_xs[i], _ys[i]);
+    }
+
+    double area() const {
+        return shoelace_area(_n, [this](size_t i) { return Point<T>(_xs[i], _ys[i]); });
+    }
+
+    Point<T> center() const {
+        return figure_center<T>(_kind, _n, [this](size_t i) { return Point<T>(_xs[i], _ys[i]); });
+    }
+
+private:
+    FigureKind _kind;
+    size_t _n;
+    const T* _xs;
+    const T* _ys;
+};
+
+// FigureStore хранит много фигур в виде структуры массивов (SoA):
+// координаты всех вершин лежат подряд в xs/ys, offsets[i] - индекс первой
+// вершины i-й фигуры (offsets[size()] == vertex_count()), kinds[i] - её вид.
+// После reserve добавление фигур не делает аллокаций
+template<Pointable T>
+class FigureStore {
+public:
+    FigureStore() { _offsets.push_back(0); }
+
+    void reserve(size_t figures, size_t vertices) {
+        _kinds.reserve(figures);
+        _offsets.reserve(figures + 1);
+        _xs.reserve(vertices);
+        _ys.reserve(vertices);
+    }
+
+    // Добавление фигуры из диапазона точек, число точек должно совпадать
+    // с числом вершин фигуры данного вида
+    template<class Range>
+    void push_back(FigureKind kind, const Range& points) {
+        const size_t n = static_cast<size_t>(std::distance(std::begin(points), std::end(points)));
+        if (n != figure_arity(kind)) throw std::invalid_argument("Wrong number of points for figure");
+        for (const auto& p : points) {
+            _xs.push_back(p.getX());
+            _ys.push_back(p.getY());
+        }
+        _kinds.push_back(kind);
+        _offsets.push_back(_xs.size());
+    }
+
+    // Добавление из Rhombus/Trapezoid/Pentagon
+    template<class F>
+        requires requires { F::kind; }
+    void push_back(const F& figure) {
+        const size_t n = figure.get_points_count();
+        if (n != figure_arity(F::kind)) throw std::invalid_argument("Wrong number of points for figure");
+        for (size_t i = 0; i < n; ++i) {
+            _xs.push_back(figure.get_point(i).getX());
+            _ys.push_back(figure.get_point(i).getY());
+        }
+        _kinds.push_back(F::kind);
+        _offsets.push_back(_xs.size());
+    }
+
+    // Дописать в конец все фигуры другого хранилища
+    void append(const FigureStore& other) {
+        const size_t shift = _xs.size();
+        _kinds.insert(_kinds.end(), other._kinds.begin(), other._kinds.end());
+        for (size_t i = 1; i < other._offsets.size(); ++i) _offsets.push_back(other._offsets[i] + shift);
+        _xs.insert(_xs.end(), other._xs.begin(), other._xs.end());
+        _ys.insert(_ys.end(), other._ys.begin(), other._ys.end());
+    }
+
+    void clear() noexcept {
+        _kinds.clear();
+        _offsets.resize(1);
+        _xs.clear();
+        _ys.clear();
+    }
+
+    // Оставить только первые figures фигур
+    void truncate(size_t figures) noexcept {
+        if (figures >= size()) return;
+        _kinds.resize(figures);
+        _offsets.resize(figures + 1);
+        _xs.resize(_offsets.back());
+        _ys.resize(_offsets.back());
+    }
+
+    size_t size() const noexcept { return _kinds.size(); }
+    size_t vertex_count() const noexcept { return _xs.size(); }
+    bool empty() const noexcept { return _kinds.empty(); }
+
+    StoredFigure<T> operator[](size_t idx) const {
+        if (idx >= size()) throw std::out_of_range("FigureStore index out of range");
+        const size_t first = _offsets[idx];
+        return StoredFigure<T>(_kinds[idx], _offsets[idx + 1] - first, _xs.data() + first, _ys.data() + first);
+    }
+
+    FigureKind kind(size_t idx) const { return (*this)[idx].kind(); }
+    double area(size_t idx) const { return (*this)[idx].area(); }
+    Point<T> center(size_t idx) const { return (*this)[idx].center(); }
+
+    // Сумма площадей всех фигур за один линейный проход
+    double total_area() const {
+        double total = 0;
+        for (size_t i = 0; i < size(); ++i) {
+            const size_t first = _offsets[i];
+            const size_t n = _offsets[i + 1] - first;
+            total += shoelace_area(n, [&](size_t j) { return Point<T>(_xs[first + j], _ys[first + j]); });
+        }
+        return total;
+    }
+
+    std::span<const T> xs() const noexcept { return _xs; }
+    std::span<const T> ys() const noexcept { return _ys; }
+    std::span<const size_t> offsets() const noexcept { return _offsets; }
+    std::span<const FigureKind> kinds() const noexcept { return _kinds; }
+
+private:
+    std::vector<FigureKind> _kinds;
+    std::vector<size_t> _offsets;
+    std::vector<T> _xs;
+    std::vector<T> _ys;
+};
@@ -0,0 +1,237 @@
+#pragma once
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <fstream>
+#include <istream>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "parallel.h"
+#include "store.h"
+
+// Быстрый разбор текстового потока фигур без iostream.
+// Формат: одна фигура на строку, первым идёт вид фигуры (R - ромб,
+// T - трапеция, P - пятиугольник), затем координаты "x y" всех вершин
+// через пробелы:
+//
+//   R 0 0 2 2 4 0 2 -2
+//   P 0 0 2 0 3 1 2 2 0 2
+//
+// Пустые строки и строки, начинающиеся с '#', пропускаются.
+// Числа читаются через std::from_chars, поэтому локаль не влияет на разбор
+
+// Ошибка разбора с позицией (строка и столбец считаются с 1)
+class ParseError : public std::runtime_error {
+public:
+    ParseError(const std::string& message, size_t line, size_t column)
+        : std::runtime_error("line " + std::to_string(line) + ", column " + std::to_string(column) + ": " + message),
+          _message(message), _line(line), _column(column) {}
+
+    // Текст ошибки без позиции
+    const std::string& message() const noexcept { return _message; }
+    size_t line() const noexcept { return _line; }
+    size_t column() const noexcept { return _column; }
+
+private:
+    std::string _message;
+    size_t _line;
+    size_t _column;
+};
+
+// Меньше этого объёма текст разбирается в одном потоке
+inline constexpr size_t kParallelParseMinBytes = size_t(1) << 20;
+
+// Поток разбирается кусками такого размера: хватает работы всем потокам,
+// а в памяти кроме хранилища только один кусок
+inline constexpr size_t kStreamParseChunkBytes = size_t(1) << 26;
+
+namespace text_detail {
+
+inline bool is_blank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+// Позиция первой ошибки в куске: смещение от начала всего текста
+struct ChunkError {
+    size_t offset;
+    std::string message;
+};
+
+inline std::optional<FigureKind> kind_from_tag(char c) {
+    switch (c) {
+    case 'R': return FigureKind::Rhombus;
+    case 'T': return FigureKind::Trapezoid;
+    case 'P': return FigureKind::Pentagon;
+    default: return std::nullopt;
+    }
+}
+
+// Разбор строк text[first, last); first и last стоят на началах строк
+template<class T>
+std::optional<ChunkError> parse_chunk(std::string_view text, size_t first, size_t last, FigureStore<T>& out) {
+    const char* const begin = text.data();
+    const char* p = begin + first;
+    const char* const end = begin + last;
+    auto error = [&](const char* at, const char* message) {
+        return ChunkError{static_cast<size_t>(at - begin), message};
+    };
+    auto skip_blanks = [&] { while (p != end && is_blank(*p)) ++p; };
+
+    Point<T> points[5];
+    while (p != end) {
+        skip_blanks();
+        if (p == end) break;
+        if (*p == '\n') { ++p; continue; }
+        if (*p == '#') {
+            while (p != end && *p != '\n') ++p;
+            continue;
+        }
+
+        const auto kind = kind_from_tag(*p);
+        if (!kind || (p + 1 != end && !is_blank(p[1]) && p[1] != '\n')) {
+            return error(p, "expected figure kind (R, T or P)");
+        }
+        ++p;
+
+        const size_t n = figure_arity(*kind);
+        for (size_t i = 0; i < n; ++i) {
+            T coord[2];
+            for (T& c : coord) {
+                skip_blanks();
+                if (p == end || *p == '\n') return error(p, "not enough coordinates for figure");
+                const auto [next, ec] = std::from_chars(p, end, c);
+                if (ec == std::errc::result_out_of_range) return error(p, "coordinate is out of range");
+                if (ec != std::errc() || (next != end && !is_blank(*next) && *next != '\n')) {
+                    return error(p, "expected number");
+                }
+                p = next;
+            }
+            points[i] = Point<T>(coord[0], coord[1]);
+        }
+
+        skip_blanks();
+        if (p != end && *p != '\n') return error(p, "too many coordinates for figure");
+        out.push_back(*kind, std::span<const Point<T>>(points, n));
+    }
+    return std::nullopt;
+}
+
+inline ParseError make_error(std::string_view text, const ChunkError& e) {
+    const size_t line = 1 + static_cast<size_t>(std::count(text.begin(), text.begin() + e.offset, '\n'));
+    const size_t line_start = text.rfind('\n', e.offset == 0 ? std::string_view::npos : e.offset - 1);
+    const size_t column = e.offset - (line_start == std::string_view::npos ? 0 : line_start + 1) + 1;
+    return ParseError(e.message, line, column);
+}
+
+} // namespace text_detail
+
+// Разбор текста в хранилище; при threads != 1 большой текст делится по
+// границам строк на куски, которые разбираются параллельно.
+// Порядок фигур всегда совпадает с порядком строк. При ParseError out
+// остаётся как был, сколько бы потоков ни разбирало текст
+template<Pointable T>
+    requires std::is_arithmetic_v<T>
+void parse_figures(std::string_view text, FigureStore<T>& out, size_t threads = 1) {
+    if (threads == 0) threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+    if (threads == 1 || text.size() < kParallelParseMinBytes) {
+        // Разбираем прямо в out и при ошибке отрезаем добавленное
+        const size_t before = out.size();
+        if (auto e = text_detail::parse_chunk(text, 0, text.size(), out)) {
+            out.truncate(before);
+            throw text_detail::make_error(text, *e);
+        }
+        return;
+    }
+
+    // Границы кусков сдвигаем на начало следующей строки
+    const size_t chunks = threads * 4;
+    std::vector<size_t> bounds{0};
+    for (size_t c = 1; c < chunks; ++c) {
+        size_t pos = std::max(bounds.back(), text.size() * c / chunks);
+        while (pos < text.size() && text[pos - 1] != '\n') ++pos;
+        if (pos > bounds.back()) bounds.push_back(pos);
+    }
+    if (bounds.back() != text.size()) bounds.push_back(text.size());
+
+    const size_t parts = bounds.size() - 1;
+    std::vector<FigureStore<T>> stores(parts);
+    std::vector<std::optional<text_detail::ChunkError>> errors(parts);
+    {
+        ThreadPool pool(threads);
+        for (size_t c = 0; c < parts; ++c) {
+            pool.submit([&, c] { errors[c] = text_detail::parse_chunk(text, bounds[c], bounds[c + 1], stores[c]); });
+        }
+        pool.wait();
+    }
+
+    for (const auto& e : errors) {
+        if (e) throw text_detail::make_error(text, *e);
+    }
+    size_t figures = out.size(), vertices = out.vertex_count();
+    for (const auto& s : stores) {
+        figures += s.size();
+        vertices += s.vertex_count();
+    }
+    // В непустое хранилище (например, при разборе потока кусками) точный
+    // reserve перекладывал бы его целиком на каждом вызове; append растёт
+    // сам, с запасом
+    if (out.empty()) out.reserve(figures, vertices);
+    for (const auto& s : stores) out.append(s);
+}
+
+// Разбор потока кусками по chunk_bytes, обрезанными по концу строки.
+// Поток не обязан уметь seek (каналы, /dev/stdin), а память не зависит от
+// размера входа. Номера строк в ParseError - по всему потоку; при ошибке
+// out остаётся как был
+template<Pointable T>
+    requires std::is_arithmetic_v<T>
+void parse_figures(std::istream& in, FigureStore<T>& out, size_t threads = 1,
+                   size_t chunk_bytes = kStreamParseChunkBytes) {
+    chunk_bytes = std::max<size_t>(chunk_bytes, 1);
+    const size_t before = out.size();
+    std::string chunk;
+    size_t line = 1;
+    try {
+        for (bool eof = false; !eof;) {
+            const size_t have = chunk.size();
+            chunk.resize(have + chunk_bytes);
+            in.read(chunk.data() + have, static_cast<std::streamsize>(chunk_bytes));
+            chunk.resize(have + static_cast<size_t>(in.gcount()));
+            if (in.bad()) throw std::runtime_error("Failed to read figures");
+            eof = !in;
+            // Неполная последняя строка ждёт следующего куска
+            size_t cut = chunk.size();
+            if (!eof) {
+                const size_t nl = chunk.rfind('\n');
+                if (nl == std::string::npos) continue;
+                cut = nl + 1;
+            }
+            const std::string_view text(chunk.data(), cut);
+            try {
+                parse_figures(text, out, threads);
+            } catch (const ParseError& e) {
+                throw ParseError(e.message(), e.line() + line - 1, e.column());
+            }
+            line += static_cast<size_t>(std::count(text.begin(), text.end(), '\n'));
+            chunk.erase(0, cut);
+        }
+    } catch (...) {
+        out.truncate(before);
+        throw;
+    }
+}
+
+// Разбор файла потоком, кусками по kStreamParseChunkBytes; годится и для
+// многогигабайтных файлов, и для каналов
+template<Pointable T>
+    requires std::is_arithmetic_v<T>
+FigureStore<T> parse_figures_file(const std::string& path, size_t threads = 0) {
+    std::ifstream is(path, std::ios::binary);
+    if (!is) throw std::runtime_error("Cannot open " + path);
+    FigureStore<T> store;
+    parse_figures(is, store, threads);
+    return store;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <iostream>
+#include <type_traits>
+#include <variant>
+#include "array.h"
+#include "figures.h"
+
+// Закрытый набор фигур, хранимый по значению: без shared_ptr, счётчика
+// ссылок и виртуального вызова. std::visit выбирает конкретный тип, а дальше
+// area()/center() из FigureBase вызываются напрямую и встраиваются
+template<class T>
+using FigureVariant = std::variant<Rhombus<T>, Trapezoid<T>, Pentagon<T>>;
+
+template<class T>
+double area(const FigureVariant<T>& figure) {
+    return std::visit([](const auto& f) { return f.area(); }, figure);
+}
+
+template<class T>
+Point<T> center(const FigureVariant<T>& figure) {
+    return std::visit([](const auto& f) { return f.center(); }, figure);
+}
+
+template<class T>
+FigureKind kind(const FigureVariant<T>& figure) {
+    return std::visit([](const auto& f) { return std::decay_t<decltype(f)>::kind; }, figure);
+}
+
+// Доступ к общему интерфейсу, если всё же нужен Figure<T>
+template<class T>
+const Figure<T>& as_figure(const FigureVariant<T>& figure) {
+    return std::visit([](const auto& f) -> const Figure<T>& { return f; }, figure);
+}
+
+template<class T>
+double total_area(const Array<FigureVariant<T>>& figures) {
+    double total = 0;
+    for (const auto& f : figures) total += area(f);
+    return total;
+}
+
+template<class T>
+std::ostream& operator<<(std::ostream& os, const FigureVariant<T>& figure) {
+    return std::visit([&os](const auto& f) -> std::ostream& { return os << f; }, figure);
+}
@@ -1,8 +1,40 @@
 #include <cmath>
+#include <cstdio>
+#include <fstream>
 #include <gtest/gtest.h>
+#include <sys/stat.h>
+#include <limits>
 #include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <random>
+#include <numeric>
 #include "../src/figures.h"
 #include "../src/array.h"
+#include "../src/store.h"
+#include "../src/simd_area.h"
+#include "../src/parallel.h"
+#include "../src/binary_io.h"
+#include "../src/text_parser.h"
+#include "../src/arena.h"
+#include "../src/variant.h"
+#include "../src/spatial_index.h"
+#include "../src/containment.h"
+#include "../src/fixed_figure.h"
+#include "../src/instrument.h"
+#include "../src/figure_view.h"
+#include "../src/factory.h"
+#include "../src/clipping.h"
+#include "../src/simplify.h"
+#include "../src/scene.h"
+#include "../src/compressed.h"
+#include "../src/pipeline.h"
+#include "../src/serializer.h"
 
 using namespace std;
 
@@ -48,6 +80,46 @@ TEST(PointContainerTest, MoveSemantics) {
     EXPECT_EQ(container2[0].getX(), 1);
 }
 
+TEST(PointContainerTest, GrowsPastInlineStorage) {
+    PointContainer<Point<int>> container;
+    EXPECT_EQ(container.capacity(), 5);
+
+    for (int i = 0; i < 1000; ++i) {
+        container.push_back(Point<int>(i, -i));
+    }
+
+    EXPECT_EQ(container.size(), 1000);
+    EXPECT_GE(container.capacity(), 1000);
+    EXPECT_EQ(container[0].getX(), 0);
+    EXPECT_EQ(container[999].getY(), -999);
+    EXPECT_THROW(container[1000], std::out_of_range);
+
+    PointContainer<Point<int>> moved = std::move(container);
+    EXPECT_EQ(moved.size(), 1000);
+    EXPECT_EQ(moved[500].getX(), 500);
+    EXPECT_EQ(container.size(), 0);
+    EXPECT_EQ(container.capacity(), 5);
+}
+
+// Добавление собственной точки, когда буфер полон и переезжает
+TEST(PointContainerTest, PushBackOwnPointOnGrowth) {
+    Polygon<int> ring;
+    for (int i = 0; i < 10; ++i) ring.add_point(Point<int>(i + 1, i * i));
+    ASSERT_EQ(ring.get_points_count(), 10);
+    ring.add_point(ring.get_point(0));
+    EXPECT_EQ(ring.get_point(10).getX(), 1);
+    EXPECT_EQ(ring.get_point(10).getY(), 0);
+
+    PointContainer<Point<int>> container;
+    for (int i = 0; i < 5; ++i) container.push_back(Point<int>(i, i));
+    container.push_back(container[0]);
+    container.append(container.begin(), container.size());
+    EXPECT_EQ(container.size(), 12);
+    EXPECT_EQ(container[5].getX(), 0);
+    EXPECT_EQ(container[11].getX(), 0);
+    EXPECT_EQ(container[10].getX(), 4);
+}
+
 // Тесты для Figure базового класса
 class TestFigure : public Figure<int> {
 public:
@@ -78,6 +150,37 @@ TEST(FigureTest, BasicOperations) {
     EXPECT_EQ(figure.get_point(3).getY(), 4);
 }
 
+TEST(FigureTest, CachedGeometryFollowsAddPoint) {
+    Pentagon<double> pentagon(std::pmr::get_default_resource());
+    Point<double> points[] = {{0, 0}, {2, 0}, {3, 1}, {2, 2}, {0, 2}};
+    for (const auto& p : points) pentagon.add_point(p);
+
+    EXPECT_DOUBLE_EQ(pentagon.area(), shoelace_area(5, [&](size_t i) { return points[i]; }));
+    EXPECT_DOUBLE_EQ(pentagon.signed_area(), 5.0);
+    EXPECT_EQ(pentagon.bounds().max_x, 3);
+    EXPECT_EQ(pentagon.bounds().min_y, 0);
+
+    // Квадрат 2x2 плюс треугольник справа: центроид смещён вправо от 1
+    Point<double> c = pentagon.centroid();
+    EXPECT_NEAR(c.getX(), (2 * 2 * 1.0 + 1 * (2 + 1.0 / 3)) / 5, 1e-12);
+    EXPECT_NEAR(c.getY(), 1.0, 1e-12);
+
+    // Обход по часовой стрелке даёт отрицательную площадь
+    Trapezoid<int> clockwise(std::pmr::get_default_resource());
+    clockwise.add_points(std::vector<Point<int>>{{0, 0}, {1, 2}, {3, 2}, {4, 0}});
+    EXPECT_FALSE(clockwise.is_dirty());
+    EXPECT_DOUBLE_EQ(clockwise.signed_area(), -6.0);
+    EXPECT_DOUBLE_EQ(static_cast<double>(clockwise), 6.0);
+
+    Trapezoid<int> copy(clockwise);
+    EXPECT_DOUBLE_EQ(copy.area(), 6.0);
+    copy.mark_dirty();
+    EXPECT_DOUBLE_EQ(copy.area(), 6.0);
+    copy.refresh();
+    EXPECT_FALSE(copy.is_dirty());
+    EXPECT_EQ(copy.bounds().max_x, 4);
+}
+
 // Тесты для Rhombus
 TEST(RhombusTest, CenterCalculation) {
     Rhombus<int> rhombus;
@@ -176,6 +279,86 @@ TEST(ArrayTest, ResizeAndReserve) {
     EXPECT_EQ(arr.size(), 5);
 }
 
+TEST(ArrayTest, DestroysRemovedElements) {
+    auto shared = make_shared<int>(42);
+    Array<shared_ptr<int>> arr;
+    for (int i = 0; i < 10; ++i) arr.push_back(shared);
+    EXPECT_EQ(shared.use_count(), 11);
+
+    arr.pop_back();
+    EXPECT_EQ(shared.use_count(), 10);
+    arr.erase(arr.begin(), arr.begin() + 3);
+    EXPECT_EQ(arr.size(), 6);
+    EXPECT_EQ(shared.use_count(), 7);
+    arr.clear();
+    EXPECT_EQ(shared.use_count(), 1);
+}
+
+TEST(ArrayTest, EmplaceInsertErase) {
+    struct NoDefault {
+        explicit NoDefault(int v) : value(v) {}
+        int value;
+    };
+    Array<NoDefault> arr;
+    for (int i = 0; i < 5; ++i) arr.emplace_back(i);
+    arr.emplace(arr.begin() + 2, 100);
+    arr.insert(arr.end(), NoDefault(200));
+    arr.erase(arr.begin());
+
+    Array<int> values;
+    for (const auto& v : arr) values.push_back(v.value);
+    ASSERT_EQ(values.size(), 6);
+    EXPECT_EQ(values[0], 1);
+    EXPECT_EQ(values[1], 100);
+    EXPECT_EQ(values[5], 200);
+    EXPECT_THROW(arr.erase(arr.end() + 1), std::out_of_range);
+
+    // Вставка элемента самого массива при переаллокации
+    Array<std::string> strings{"a", "b"};
+    strings.push_back(strings[0]);
+    strings.insert(strings.begin(), strings[2]);
+    EXPECT_EQ(strings[0], "a");
+    EXPECT_EQ(strings[3], "a");
+    EXPECT_EQ(strings.size(), 4);
+}
+
+// Перемещение не noexcept, поэтому Array переносит такие элементы
+// копированием; копия бросает, когда copies_left кончается
+struct Fragile {
+    static inline int live = 0;
+    static inline int copies_left = 0;
+    explicit Fragile(int v) : value(v) { ++live; }
+    Fragile(const Fragile& other) : value(other.value) {
+        if (copies_left-- == 0) throw std::runtime_error("copy failed");
+        ++live;
+    }
+    Fragile(Fragile&& other) noexcept(false) : value(other.value) { ++live; }
+    ~Fragile() { --live; }
+    int value;
+};
+
+TEST(ArrayTest, ReserveKeepsArrayWhenCopyThrows) {
+    // Третья копия бросает: массив прежний, копии разрушены, новый буфер
+    // освобождён (утечку ловит LeakSanitizer)
+    {
+        Array<Fragile> arr;
+        arr.reserve(10);
+        for (int i = 0; i < 10; ++i) arr.emplace_back(i);
+        Fragile::copies_left = 2;
+        EXPECT_THROW(arr.reserve(100), std::runtime_error);
+        EXPECT_EQ(Fragile::live, 10);
+        ASSERT_EQ(arr.size(), 10);
+        EXPECT_EQ(arr.capacity(), 10);
+        EXPECT_EQ(arr[9].value, 9);
+
+        Fragile::copies_left = 100;
+        arr.reserve(100);
+        EXPECT_EQ(arr.capacity(), 100);
+        EXPECT_EQ(arr[9].value, 9);
+    }
+    EXPECT_EQ(Fragile::live, 0);
+}
+
 TEST(ArrayFigureTest, StoreFigures) {
     Array<shared_ptr<Figure<int>>> figures;
     
@@ -226,6 +409,1420 @@ TEST(ArrayFigureTest, TotalAreaCalculation) {
     EXPECT_NEAR(total_area, 8.0 + 6.0, 0.1);
 }
 
+// Тесты для FigureStore
+TEST(FigureStoreTest, MatchesFigureObjects) {
+    Rhombus<int> rhombus;
+    rhombus.add_point(Point<int>(0, 0));
+    rhombus.add_point(Point<int>(2, 2));
+    rhombus.add_point(Point<int>(4, 0));
+    rhombus.add_point(Point<int>(2, -2));
+
+    Pentagon<int> pentagon;
+    pentagon.add_point(Point<int>(0, 0));
+    pentagon.add_point(Point<int>(2, 0));
+    pentagon.add_point(Point<int>(3, 1));
+    pentagon.add_point(Point<int>(2, 2));
+    pentagon.add_point(Point<int>(0, 2));
+
+    FigureStore<int> store;
+    store.reserve(3, 13);
+    store.push_back(rhombus);
+    store.push_back(pentagon);
+    Point<int> trapezoid[] = {{0, 0}, {4, 0}, {3, 2}, {1, 2}};
+    store.push_back(FigureKind::Trapezoid, trapezoid);
+
+    ASSERT_EQ(store.size(), 3);
+    EXPECT_EQ(store.vertex_count(), 13);
+    EXPECT_EQ(store.offsets()[2], 9);
+    EXPECT_EQ(store.kind(1), FigureKind::Pentagon);
+    EXPECT_EQ(store[1].point(4).getY(), 2);
+
+    EXPECT_DOUBLE_EQ(store.area(0), static_cast<double>(rhombus));
+    EXPECT_DOUBLE_EQ(store.area(1), static_cast<double>(pentagon));
+    EXPECT_DOUBLE_EQ(store.area(2), 6.0);
+    EXPECT_EQ(store.center(0).getX(), rhombus.center().getX());
+    EXPECT_EQ(store.center(1).getY(), pentagon.center().getY());
+    EXPECT_DOUBLE_EQ(store.total_area(), store.area(0) + store.area(1) + 6.0);
+
+    EXPECT_THROW(store.push_back(FigureKind::Pentagon, trapezoid), std::invalid_argument);
+    EXPECT_THROW(store[3], std::out_of_range);
+}
+
+// Тесты для пакетного вычисления площадей
+TEST(SimdAreaTest, AllLevelsMatchScalar) {
+    FigureStore<int> store;
+    for (int i = 0; i < 103; ++i) {
+        Point<int> quad[] = {{i, 0}, {i + 4, 1}, {i + 3, 2 + i % 7}, {-i, 2}};
+        Point<int> penta[] = {{0, 0}, {2 * i, 0}, {3 * i, i}, {2 * i, 2 * i}, {0, 2 + i}};
+        if (i % 3 == 0) store.push_back(FigureKind::Pentagon, penta);
+        else store.push_back(i % 2 ? FigureKind::Rhombus : FigureKind::Trapezoid, quad);
+    }
+
+    const SimdLevel best = detect_simd_level();
+    for (SimdLevel level : {SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2}) {
+        if (level > best) continue;
+        std::vector<double> result = areas(store, level);
+        ASSERT_EQ(result.size(), store.size());
+        for (size_t i = 0; i < store.size(); ++i) {
+            EXPECT_DOUBLE_EQ(result[i], store.area(i));
+        }
+        EXPECT_DOUBLE_EQ(simd_total_area(store, level), store.total_area());
+    }
+
+    std::vector<double> wrong(2);
+    EXPECT_THROW(areas(store, std::span<double>(wrong)), std::invalid_argument);
+}
+
+// Длинные участки одного вида, чтобы работали все ширины ядер и хвосты;
+// результат побитно совпадает со скалярным
+template<class T>
+static void check_long_runs() {
+    FigureStore<T> store;
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<int> coord(-1000000, 1000000);
+    auto value = [&] { return std::is_integral_v<T> ? T(coord(rng)) : T(coord(rng) / 7.0); };
+    for (size_t run = 1; run <= 13; ++run) {
+        const FigureKind kind = run % 2 ? FigureKind::Pentagon : FigureKind::Rhombus;
+        for (size_t f = 0; f < run; ++f) {
+            Point<T> points[5];
+            for (auto& p : points) p = Point<T>(value(), value());
+            store.push_back(kind, std::span<const Point<T>>(points, figure_arity(kind)));
+        }
+    }
+    for (SimdLevel level : {SimdLevel::Scalar, SimdLevel::SSE2, SimdLevel::AVX2}) {
+        if (level > detect_simd_level()) continue;
+        const std::vector<double> result = areas(store, level);
+        for (size_t i = 0; i < store.size(); ++i) EXPECT_EQ(result[i], store.area(i)) << "figure " << i;
+    }
+}
+
+TEST(SimdAreaTest, LongRunsMatchScalarBitwise) {
+    check_long_runs<int32_t>();
+    check_long_runs<float>();
+    check_long_runs<double>();
+}
+
+// Тесты для параллельных вычислений
+TEST(ParallelTest, TotalAreaDoesNotDependOnThreads) {
+    Array<shared_ptr<Figure<double>>> figures;
+    for (int i = 0; i < 10000; ++i) {
+        auto trapezoid = make_shared<Trapezoid<double>>();
+        const double s = 1.0 + i * 0.001;
+        trapezoid->add_point(Point<double>(0, 0));
+        trapezoid->add_point(Point<double>(4 * s, 0));
+        trapezoid->add_point(Point<double>(3 * s, 2 * s));
+        trapezoid->add_point(Point<double>(s, 2 * s));
+        figures.push_back(trapezoid);
+    }
+
+    const double one = parallel_total_area(figures, 1);
+    EXPECT_EQ(parallel_total_area(figures, 2), one);
+    EXPECT_EQ(parallel_total_area(figures, 7), one);
+
+    double serial = 0;
+    for (size_t i = 0; i < figures.size(); ++i) serial += static_cast<double>(*figures[i]);
+    EXPECT_NEAR(one, serial, 1e-6);
+
+    Array<Point<double>> centers;
+    parallel_centers(figures, centers, 3);
+    ASSERT_EQ(centers.size(), figures.size());
+    EXPECT_DOUBLE_EQ(centers[9999].getX(), figures[9999]->center().getX());
+    EXPECT_DOUBLE_EQ(centers[42].getY(), figures[42]->center().getY());
+}
+
+TEST(ParallelTest, ThreadPoolRethrowsTaskErrors) {
+    ThreadPool pool(2);
+    std::atomic<int> done{0};
+    for (int i = 0; i < 100; ++i) pool.submit([&] { ++done; });
+    pool.submit([] { throw std::runtime_error("boom"); });
+    EXPECT_THROW(pool.wait(), std::runtime_error);
+    EXPECT_EQ(done.load(), 100);
+    pool.wait();
+}
+
+// Тесты для двоичного формата
+TEST(BinaryIoTest, WriteAndMap) {
+    FigureStore<double> store;
+    Point<double> rhombus[] = {{0, 0}, {2, 2}, {4, 0}, {2, -2}};
+    Point<double> pentagon[] = {{0, 0}, {2, 0}, {3, 1}, {2, 2}, {0, 2}};
+    store.push_back(FigureKind::Rhombus, rhombus);
+    store.push_back(FigureKind::Pentagon, pentagon);
+    store.push_back(FigureKind::Rhombus, rhombus);
+
+    const std::string path = testing::TempDir() + "figures_test.bin";
+    write_figures(path, store);
+
+    MappedFigureFile<double> file(path);
+    ASSERT_EQ(file.size(), 3);
+    EXPECT_EQ(file.vertex_count(), 13);
+    EXPECT_EQ(file[1].kind(), FigureKind::Pentagon);
+    EXPECT_DOUBLE_EQ(file[1].point(2).getX(), 3);
+    EXPECT_DOUBLE_EQ(file[0].area(), 8.0);
+    EXPECT_DOUBLE_EQ(file.total_area(), store.total_area());
+    EXPECT_EQ(file[2].center().getX(), store.center(2).getX());
+
+    FigureStore<double> loaded = file.load();
+    EXPECT_EQ(loaded.size(), store.size());
+    EXPECT_DOUBLE_EQ(loaded.area(1), store.area(1));
+
+    EXPECT_THROW(MappedFigureFile<int> wrong_type(path), std::runtime_error);
+    {
+        std::ofstream os(path, std::ios::binary | std::ios::trunc);
+        os << "not a figure file at all, just some text that is long enough for a header";
+    }
+    EXPECT_THROW(MappedFigureFile<double> garbage(path), std::runtime_error);
+    std::remove(path.c_str());
+}
+
+// Тесты для текстового разбора
+TEST(TextParserTest, ParsesFiguresPerLine) {
+    FigureStore<int> store;
+    parse_figures<int>("# сцена\nR 0 0 2 2 4 0 2 -2\n\n  T 0 0 4 0 3 2 1 2\r\nP 0 0 2 0 3 1 2 2 0 2", store);
+
+    ASSERT_EQ(store.size(), 3);
+    EXPECT_EQ(store.kind(0), FigureKind::Rhombus);
+    EXPECT_EQ(store.kind(2), FigureKind::Pentagon);
+    EXPECT_DOUBLE_EQ(store.area(0), 8.0);
+    EXPECT_DOUBLE_EQ(store.area(1), 6.0);
+    EXPECT_EQ(store[2].point(4).getY(), 2);
+}
+
+TEST(TextParserTest, ReportsErrorPosition) {
+    FigureStore<int> store;
+    try {
+        parse_figures<int>("R 0 0 2 2 4 0 2 -2\nT 0 0 4 x 3 2 1 2\n", store);
+        FAIL() << "ParseError expected";
+    } catch (const ParseError& e) {
+        EXPECT_EQ(e.line(), 2);
+        EXPECT_EQ(e.column(), 9);
+    }
+    EXPECT_THROW(parse_figures<int>("Q 1 2\n", store), ParseError);
+    EXPECT_THROW(parse_figures<int>("R 0 0 2 2 4 0\n", store), ParseError);
+    EXPECT_THROW(parse_figures<int>("R 0 0 2 2 4 0 2 -2 7\n", store), ParseError);
+    EXPECT_THROW(parse_figures<int>("R 0 0 2 2 4 0 2 99999999999\n", store), ParseError);
+}
+
+TEST(TextParserTest, ParallelMatchesSerial) {
+    std::string text;
+    for (int i = 0; i < 60000; ++i) {
+        text += "P 0 0 " + std::to_string(i) + " 0 3.5 1 2 2 0 " + std::to_string(i % 17) + "\n";
+    }
+    ASSERT_GT(text.size(), kParallelParseMinBytes);
+
+    FigureStore<double> serial, parallel;
+    parse_figures<double>(text, serial, 1);
+    parse_figures<double>(text, parallel, 4);
+    ASSERT_EQ(parallel.size(), 60000);
+    ASSERT_EQ(parallel.vertex_count(), serial.vertex_count());
+    EXPECT_DOUBLE_EQ(parallel.total_area(), serial.total_area());
+    EXPECT_DOUBLE_EQ(parallel[59999].point(1).getX(), 59999);
+
+    text += "P 1 2 oops\n";
+    try {
+        parse_figures<double>(text, parallel, 4);
+        FAIL() << "ParseError expected";
+    } catch (const ParseError& e) {
+        EXPECT_EQ(e.line(), 60001);
+        EXPECT_EQ(e.column(), 7);
+    }
+}
+
+TEST(TextParserTest, ErrorLeavesStoreUnchanged) {
+    // Одинаково в одном потоке и параллельно: ничего из ошибочного текста
+    std::string text;
+    for (int i = 0; i < 60000; ++i) text += "R 0 0 2 2 4 0 2 " + std::to_string(-i) + "\n";
+    text += "T 0 0 4 x 3 2 1 2\n";
+    ASSERT_GT(text.size(), kParallelParseMinBytes);
+
+    for (size_t threads : {size_t(1), size_t(4)}) {
+        FigureStore<int> store;
+        parse_figures<int>("P 0 0 2 0 3 1 2 2 0 2\n", store);
+        EXPECT_THROW(parse_figures<int>(text, store, threads), ParseError);
+        ASSERT_EQ(store.size(), 1) << "threads = " << threads;
+        EXPECT_EQ(store.vertex_count(), 5);
+        EXPECT_EQ(store.offsets().size(), 2);
+        EXPECT_EQ(store.kind(0), FigureKind::Pentagon);
+
+        // Хранилище годится для дальнейшей работы
+        parse_figures<int>("R 0 0 2 2 4 0 2 -2\n", store, threads);
+        ASSERT_EQ(store.size(), 2);
+        EXPECT_DOUBLE_EQ(store.area(1), 8.0);
+    }
+}
+
+TEST(TextParserTest, StreamInChunks) {
+    std::string text = "# сцена\n";
+    for (int i = 0; i < 300; ++i) text += "R 0 0 2 2 4 0 2 " + std::to_string(-i) + (i % 5 ? "\n" : "\n\n");
+    FigureStore<int> whole;
+    parse_figures<int>(text, whole);
+
+    // Куски меньше строки, около строки и больше всего текста
+    for (size_t chunk : {size_t(1), size_t(7), size_t(20), size_t(333), size_t(1) << 20}) {
+        std::istringstream in(text);
+        FigureStore<int> store;
+        parse_figures(in, store, 1, chunk);
+        ASSERT_EQ(store.size(), whole.size()) << "chunk = " << chunk;
+        EXPECT_DOUBLE_EQ(store.total_area(), whole.total_area());
+
+        // Номер строки - по всему потоку, добавленное отрезается
+        std::istringstream bad(text + "R 0 0 2 2 4 0 2 -2\nT 0 0 4 x 3 2 1 2\n");
+        try {
+            parse_figures(bad, store, 1, chunk);
+            ADD_FAILURE() << "ParseError expected, chunk = " << chunk;
+        } catch (const ParseError& e) {
+            EXPECT_EQ(e.line(), 363);
+            EXPECT_EQ(e.column(), 9);
+            EXPECT_EQ(e.message(), "expected number");
+        }
+        EXPECT_EQ(store.size(), whole.size());
+    }
+}
+
+TEST(TextParserTest, ParseFileFromPipe) {
+    // Из канала tellg не работает; файл читается потоком
+    const std::string path = testing::TempDir() + "figures_test.fifo";
+    std::remove(path.c_str());
+    ASSERT_EQ(mkfifo(path.c_str(), 0600), 0);
+    std::thread writer([&] {
+        std::ofstream os(path, std::ios::binary);
+        for (int i = 0; i < 1000; ++i) os << "P 0 0 2 0 3 1 2 2 0 " << i % 3 + 2 << "\n";
+    });
+    const FigureStore<double> store = parse_figures_file<double>(path, 2);
+    writer.join();
+    std::remove(path.c_str());
+    ASSERT_EQ(store.size(), 1000);
+    EXPECT_EQ(store.kind(999), FigureKind::Pentagon);
+}
+
+// Тесты для арены
+TEST(ArenaTest, SceneLivesInArena) {
+    Arena arena(4096);
+    {
+        Array<shared_ptr<Figure<int>>> figures;
+        for (int i = 0; i < 100; ++i) {
+            auto pentagon = make_shared_in<Pentagon<int>>(arena);
+            for (int v = 0; v < 8; ++v) pentagon->add_point(Point<int>(v, i));
+            figures.push_back(pentagon);
+        }
+        EXPECT_EQ(figures[99]->get_points_count(), 8);
+        EXPECT_EQ(figures[99]->get_point(7).getY(), 99);
+        EXPECT_GT(arena.bytes_used(), 100 * 8 * sizeof(Point<int>));
+
+        // Копия фигуры живёт уже в обычной куче
+        Pentagon<int> copy(static_cast<Pentagon<int>&>(*figures[0]));
+        EXPECT_EQ(copy.get_points_count(), 8);
+    }
+    arena.release();
+    EXPECT_EQ(arena.bytes_used(), 0);
+
+    auto big = make_shared_in<Rhombus<int>>(arena);
+    EXPECT_NE(big, nullptr);
+}
+
+// Тесты для FigureVariant
+TEST(FigureVariantTest, MatchesVirtualInterface) {
+    Rhombus<int> rhombus;
+    rhombus.add_point(Point<int>(0, 0));
+    rhombus.add_point(Point<int>(2, 2));
+    rhombus.add_point(Point<int>(4, 0));
+    rhombus.add_point(Point<int>(2, -2));
+
+    Trapezoid<int> trapezoid;
+    trapezoid.add_point(Point<int>(0, 0));
+    trapezoid.add_point(Point<int>(4, 0));
+    trapezoid.add_point(Point<int>(3, 2));
+    trapezoid.add_point(Point<int>(1, 2));
+
+    Array<FigureVariant<int>> figures;
+    figures.emplace_back(rhombus);
+    figures.emplace_back(std::move(trapezoid));
+
+    EXPECT_EQ(kind(figures[0]), FigureKind::Rhombus);
+    EXPECT_EQ(kind(figures[1]), FigureKind::Trapezoid);
+    EXPECT_DOUBLE_EQ(area(figures[0]), 8.0);
+    EXPECT_DOUBLE_EQ(total_area(figures), 14.0);
+    EXPECT_EQ(center(figures[0]).getX(), rhombus.center().getX());
+    EXPECT_EQ(as_figure(figures[1]).get_points_count(), 4);
+
+    std::ostringstream via_variant, direct;
+    via_variant << figures[0];
+    direct << rhombus;
+    EXPECT_EQ(via_variant.str(), direct.str());
+}
+
+// Тесты для пространственных индексов
+static Array<shared_ptr<Figure<int>>> random_scene(size_t n, unsigned seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> pos(-1000, 1000), size(1, 30);
+    Array<shared_ptr<Figure<int>>> figures;
+    for (size_t i = 0; i < n; ++i) {
+        auto rhombus = make_shared<Rhombus<int>>(std::pmr::get_default_resource());
+        const int x = pos(rng), y = pos(rng), w = size(rng), h = size(rng);
+        rhombus->add_point(Point<int>(x - w, y));
+        rhombus->add_point(Point<int>(x, y + h));
+        rhombus->add_point(Point<int>(x + w, y));
+        rhombus->add_point(Point<int>(x, y - h));
+        figures.push_back(rhombus);
+    }
+    return figures;
+}
+
+TEST(SpatialIndexTest, MatchesBruteForce) {
+    const auto figures = random_scene(3000, 7);
+    RTree<int> tree(figures, 8);
+    UniformGrid<int> grid(figures, 50);
+    EXPECT_EQ(tree.size(), 3000);
+
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<int> pos(-1100, 1100);
+    for (int q = 0; q < 50; ++q) {
+        const int x = pos(rng), y = pos(rng);
+        const Bounds<int> window{x, y, x + 120, y + 80};
+        std::vector<size_t> expected;
+        for (size_t i = 0; i < figures.size(); ++i) {
+            if (figures[i]->bounds().intersects(window)) expected.push_back(i);
+        }
+        auto found = tree.query(window);
+        std::sort(found.begin(), found.end());
+        EXPECT_EQ(found, expected);
+        EXPECT_EQ(grid.query(window), expected);
+
+        std::vector<size_t> hits;
+        for (size_t i = 0; i < figures.size(); ++i) {
+            if (figures[i]->bounds().contains(Point<int>(x, y))) hits.push_back(i);
+        }
+        auto tree_hits = tree.candidates(Point<int>(x, y));
+        auto grid_hits = grid.candidates(Point<int>(x, y));
+        std::sort(tree_hits.begin(), tree_hits.end());
+        std::sort(grid_hits.begin(), grid_hits.end());
+        EXPECT_EQ(tree_hits, hits);
+        EXPECT_EQ(grid_hits, hits);
+
+        auto dist2 = [&](size_t i) {
+            const auto c = figures[i]->center();
+            const double dx = c.getX() - x, dy = c.getY() - y;
+            return dx * dx + dy * dy;
+        };
+        std::vector<size_t> order(figures.size());
+        for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return dist2(a) < dist2(b); });
+        const auto knn = tree.nearest(Point<int>(x, y), 5);
+        ASSERT_EQ(knn.size(), 5);
+        for (size_t k = 0; k < 5; ++k) EXPECT_DOUBLE_EQ(dist2(knn[k]), dist2(order[k]));
+    }
+}
+
+TEST(SpatialIndexTest, GridReportsEachFigureOnce) {
+    // Клетки мельче фигур: каждая фигура лежит в нескольких клетках, а окна
+    // выходят за габарит сцены и упираются в границы клеток
+    const auto figures = random_scene(1000, 3);
+    for (double cell : {4.0, 10.0, 333.0, 5000.0}) {
+        UniformGrid<int> grid(figures, cell);
+        std::mt19937 rng(5);
+        std::uniform_int_distribution<int> pos(-1200, 1200), size(0, 300);
+        for (int q = 0; q < 40; ++q) {
+            const int x = pos(rng), y = pos(rng);
+            const Bounds<int> window{x, y, x + size(rng), y + size(rng)};
+            std::vector<size_t> expected;
+            for (size_t i = 0; i < figures.size(); ++i) {
+                if (figures[i]->bounds().intersects(window)) expected.push_back(i);
+            }
+            EXPECT_EQ(grid.query(window), expected) << "cell " << cell;
+        }
+    }
+}
+
+TEST(SpatialIndexTest, GridRejectsTooManyCells) {
+    const auto figures = random_scene(10, 1);
+    EXPECT_THROW(UniformGrid<int>(figures, 1e-3), std::invalid_argument);
+    EXPECT_THROW(UniformGrid<int>(figures, 1e-300), std::invalid_argument);
+    EXPECT_THROW(UniformGrid<int>(figures, 0), std::invalid_argument);
+    EXPECT_NO_THROW(UniformGrid<int>(figures, 1));
+}
+
+// Тесты для проверки принадлежности точек
+TEST(ContainmentTest, BoundaryAndVertices) {
+    Pentagon<int> pentagon(std::pmr::get_default_resource());
+    for (auto [x, y] : {std::pair{0, 0}, {4, 0}, {6, 3}, {2, 6}, {-2, 3}}) pentagon.add_point(Point<int>(x, y));
+    PolygonEdges<int> edges(pentagon);
+    EXPECT_EQ(edges.size(), 5);
+
+    const std::vector<Point<int>> queries = {
+        Point<int>(2, 3), Point<int>(0, 0), Point<int>(2, 0), Point<int>(4, 1),
+        Point<int>(-1, 0), Point<int>(2, 7), Point<int>(6, 3), Point<int>(-3, 3), Point<int>(7, 3)};
+    std::vector<uint8_t> flags(queries.size());
+    contains<int>(pentagon, queries, flags);
+    EXPECT_EQ(flags, (std::vector<uint8_t>{1, 1, 1, 1, 0, 0, 1, 0, 0}));
+    EXPECT_TRUE(edges.contains(Point<int>(2, 6)));
+    EXPECT_FALSE(edges.contains(Point<int>(3, 6)));
+
+    std::vector<uint8_t> wrong(2);
+    EXPECT_THROW(edges.contains(queries, wrong), std::invalid_argument);
+}
+
+TEST(ContainmentTest, ExactForLargeCoordinates) {
+    // Векторные произведения не помещаются в int64 и теряют точность в double
+    const long long big = 3'000'000'000'000LL;
+    Rhombus<long long> rhombus(std::pmr::get_default_resource());
+    rhombus.add_point(Point<long long>(-big, 0));
+    rhombus.add_point(Point<long long>(0, big + 1));
+    rhombus.add_point(Point<long long>(big, 0));
+    rhombus.add_point(Point<long long>(0, -big - 1));
+    PolygonEdges<long long> edges(rhombus);
+    EXPECT_TRUE(edges.contains(Point<long long>(big - 1, 0)));
+    EXPECT_TRUE(edges.contains(Point<long long>(big, 0)));
+    EXPECT_FALSE(edges.contains(Point<long long>(big + 1, 0)));
+    EXPECT_FALSE(edges.contains(Point<long long>(big / 2, big / 2 + 2)));
+}
+
+TEST(ContainmentTest, FullRangeIntCoordinates) {
+    const int lo = std::numeric_limits<int>::min(), hi = std::numeric_limits<int>::max();
+    Polygon<int> square;
+    for (const auto& p : {Point<int>(lo, lo), Point<int>(hi, lo), Point<int>(hi, hi), Point<int>(lo, hi)}) square.add_point(p);
+    PolygonEdges<int> edges(square);
+    EXPECT_TRUE(edges.contains(Point<int>(lo + 1, hi - 1)));
+    EXPECT_TRUE(edges.contains(Point<int>(hi, 0)));
+    EXPECT_TRUE(edges.contains(Point<int>(lo, lo)));
+
+    // Тонкий треугольник около ±2^31: точки по разные стороны гипотенузы
+    Polygon<int> triangle;
+    for (const auto& p : {Point<int>(lo, lo), Point<int>(hi, hi - 1), Point<int>(lo, lo + 2)}) triangle.add_point(p);
+    PolygonEdges<int> thin(triangle);
+    EXPECT_TRUE(thin.contains(Point<int>(0, 0)));
+    EXPECT_FALSE(thin.contains(Point<int>(0, 1)));
+    EXPECT_FALSE(thin.contains(Point<int>(0, -1)));
+    EXPECT_FALSE(thin.contains(Point<int>(hi, hi)));
+
+    // 64-битные координаты ограничены ±2^62
+    const long long limit = 1LL << 62;
+    Polygon<long long> wide;
+    for (const auto& p : {Point<long long>(-limit, -limit), Point<long long>(limit, -limit), Point<long long>(limit, limit),
+                          Point<long long>(-limit, limit)}) {
+        wide.add_point(p);
+    }
+    PolygonEdges<long long> wide_edges(wide);
+    EXPECT_TRUE(wide_edges.contains(Point<long long>(-limit + 1, limit - 1)));
+    EXPECT_TRUE(wide_edges.contains(Point<long long>(-limit, limit - 1)));
+    EXPECT_THROW(wide_edges.contains(Point<long long>(limit + 1, 0)), std::out_of_range);
+    Polygon<long long> sliver;
+    for (const auto& p : {Point<long long>(-limit, -limit), Point<long long>(limit, limit - 1), Point<long long>(-limit, -limit + 2)}) {
+        sliver.add_point(p);
+    }
+    PolygonEdges<long long> sliver_edges(sliver);
+    EXPECT_TRUE(sliver_edges.contains(Point<long long>(0, 0)));
+    EXPECT_FALSE(sliver_edges.contains(Point<long long>(0, 1)));
+    EXPECT_FALSE(sliver_edges.contains(Point<long long>(0, -1)));
+    wide.add_point(Point<long long>(std::numeric_limits<long long>::max(), 0));
+    EXPECT_THROW(PolygonEdges<long long>{wide}, std::out_of_range);
+}
+
+TEST(ContainmentTest, FilterMatchesExactNearEdges) {
+    // Точки на рёбрах и рядом с ними при больших 32-битных координатах.
+    // Сдвиг берём из соотношения Безу dx * b - dy * a = g, тогда векторное
+    // произведение равно s * g - единицы при множителях порядка 2^64, и в
+    // double оно обычно обращается в ноль. Эталон - те же фигуры в long long,
+    // они всегда считаются в int128
+    auto bezout = [](long long x, long long y, long long& u, long long& v) {
+        // x * u + y * v = gcd(x, y)
+        long long u0 = 1, v0 = 0, u1 = 0, v1 = 1;
+        while (y != 0) {
+            const long long q = x / y;
+            std::tie(x, y) = std::make_pair(y, x - q * y);
+            std::tie(u0, u1) = std::make_pair(u1, u0 - q * u1);
+            std::tie(v0, v1) = std::make_pair(v1, v0 - q * v1);
+        }
+        u = u0;
+        v = v0;
+    };
+    std::mt19937 rng(17);
+    std::uniform_int_distribution<int> coord(-2'000'000'000, 2'000'000'000), shift(-2, 2), t(0, 1000);
+    for (int f = 0; f < 20; ++f) {
+        Polygon<int> polygon;
+        Polygon<long long> reference;
+        for (int v = 0; v < 5; ++v) {
+            const int x = coord(rng), y = coord(rng);
+            polygon.add_point(Point<int>(x, y));
+            reference.add_point(Point<long long>(x, y));
+        }
+        std::vector<Point<int>> queries;
+        std::vector<Point<long long>> wide_queries;
+        for (int q = 0; q < 500; ++q) {
+            const auto& p = polygon.get_point(q % 5);
+            const auto& r = polygon.get_point((q + 1) % 5);
+            const long long dx = static_cast<long long>(r.getX()) - p.getX();
+            const long long dy = static_cast<long long>(r.getY()) - p.getY();
+            const long long g = std::gcd(dx, dy);
+            long long b = 0, a = 0;
+            bezout(dx, -dy, b, a);
+            // s сдвигов Безу от начала ребра, затем узел решётки вдоль
+            // ребра, чтобы точка вернулась к его середине
+            const long long s = shift(rng), ux = dx / g, uy = dy / g;
+            const long double fx = ux, fy = uy;
+            const long double along = s * (a * fx + b * fy) / (fx * fx + fy * fy);
+            const long long k = std::llround(g * t(rng) / 1000.0L - along);
+            const long long x = p.getX() + ux * k + s * a;
+            const long long y = p.getY() + uy * k + s * b;
+            if (x < std::numeric_limits<int>::min() || x > std::numeric_limits<int>::max() ||
+                y < std::numeric_limits<int>::min() || y > std::numeric_limits<int>::max()) {
+                continue;
+            }
+            queries.emplace_back(static_cast<int>(x), static_cast<int>(y));
+            wide_queries.emplace_back(x, y);
+        }
+        std::vector<uint8_t> flags(queries.size()), expected(queries.size());
+        PolygonEdges<int>(polygon).contains(queries, flags);
+        PolygonEdges<long long>(reference).contains(wide_queries, expected);
+        ASSERT_GT(queries.size(), 400u);
+        EXPECT_EQ(flags, expected);
+    }
+}
+
+TEST(ContainmentTest, SetMatchesBruteForce) {
+    const auto figures = random_scene(500, 3);
+    PolygonSet<int> set(figures);
+    EXPECT_EQ(set.size(), 500);
+
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<int> pos(-1050, 1050);
+    std::vector<Point<int>> queries;
+    for (int i = 0; i < 2000; ++i) queries.emplace_back(pos(rng), pos(rng));
+    std::vector<size_t> located(queries.size());
+    set.locate(queries, located);
+    const auto counts = set.count_inside(queries);
+
+    // Ромб |dx|/w + |dy|/h <= 1 проверяем в целых числах
+    auto inside = [&](size_t f, const Point<int>& p) {
+        const auto& fig = *figures[f];
+        const long long cx = fig.get_point(1).getX(), cy = fig.get_point(0).getY();
+        const long long w = fig.get_point(2).getX() - cx, h = fig.get_point(1).getY() - cy;
+        return std::llabs(p.getX() - cx) * h + std::llabs(p.getY() - cy) * w <= w * h;
+    };
+    std::vector<size_t> expected_counts(figures.size(), 0);
+    for (size_t q = 0; q < queries.size(); ++q) {
+        size_t expected = PolygonSet<int>::npos;
+        for (size_t f = 0; f < figures.size(); ++f) {
+            if (!inside(f, queries[q])) continue;
+            if (expected == PolygonSet<int>::npos) expected = f;
+            ++expected_counts[f];
+        }
+        EXPECT_EQ(located[q], expected);
+    }
+    EXPECT_EQ(counts, expected_counts);
+}
+
+// Тесты для фигур фиксированного размера
+TEST(FixedFigureTest, ConstexprGeometry) {
+    constexpr FixedRhombus<int> rhombus(Point<int>(0, 0), Point<int>(2, 2), Point<int>(4, 0), Point<int>(2, -2));
+    static_assert(rhombus.area() == 8.0);
+    static_assert(rhombus.center().getX() == 2 && rhombus.center().getY() == 0);
+    constexpr FixedTrapezoid<double> trapezoid(Point<double>(0, 0), Point<double>(4, 0), Point<double>(3, 2), Point<double>(1, 2));
+    static_assert(trapezoid.area() == 6.0);
+    static_assert(sizeof(FixedRhombus<int>) == 32 && sizeof(FixedPentagon<double>) == 80);
+    static_assert(std::is_trivially_copyable_v<FixedPentagon<int>>);
+
+    std::ostringstream fixed_out, dynamic_out;
+    Rhombus<int> dynamic(std::pmr::get_default_resource());
+    for (const auto& p : rhombus.points()) dynamic.add_point(p);
+    fixed_out << rhombus;
+    dynamic_out << dynamic;
+    EXPECT_EQ(fixed_out.str(), dynamic_out.str());
+    EXPECT_THROW(rhombus.get_point(4), std::out_of_range);
+}
+
+TEST(FixedFigureTest, MatchesDynamicFigures) {
+    std::mt19937 rng(21);
+    std::uniform_real_distribution<double> coord(-100, 100);
+    for (int iter = 0; iter < 100; ++iter) {
+        Pentagon<double> pentagon(std::pmr::get_default_resource());
+        for (int i = 0; i < 5; ++i) pentagon.add_point(Point<double>(coord(rng), coord(rng)));
+        const auto fixed = FixedPentagon<double>::from(pentagon);
+        EXPECT_EQ(fixed.area(), pentagon.area());
+        EXPECT_EQ(fixed.center().getX(), pentagon.center().getX());
+        EXPECT_EQ(fixed.center().getY(), pentagon.center().getY());
+    }
+
+    Trapezoid<int> short_one(std::pmr::get_default_resource());
+    short_one.add_point(Point<int>(0, 0));
+    EXPECT_THROW(FixedTrapezoid<int>::from(short_one), std::invalid_argument);
+
+    FigureStore<int> store;
+    store.push_back(FixedTrapezoid<int>(Point<int>(0, 0), Point<int>(4, 0), Point<int>(3, 2), Point<int>(1, 2)));
+    EXPECT_EQ(store.kind(0), FigureKind::Trapezoid);
+    EXPECT_DOUBLE_EQ(store.area(0), 6.0);
+}
+
+// Тесты для политик арифметики
+TEST(ArithmeticPolicyTest, PentagonCenterNoOverflow) {
+    Pentagon<int> negative(std::pmr::get_default_resource());
+    for (auto [x, y] : {std::pair{-4, -2}, {0, 0}, {-1, -5}, {9, 9}, {-4, -2}}) negative.add_point(Point<int>(x, y));
+    EXPECT_EQ(negative.center().getX(), -3);
+    EXPECT_EQ(negative.center().getY(), -3);
+
+    const int big = 2'000'000'000;
+    Pentagon<int> huge(std::pmr::get_default_resource());
+    for (int i = 0; i < 5; ++i) huge.add_point(Point<int>(big, big - i));
+    EXPECT_EQ(huge.center().getX(), big);
+    EXPECT_EQ(huge.center<ExactArithmetic>().getY(), big - 2);
+
+    Rhombus<int> rhombus(std::pmr::get_default_resource());
+    for (auto [x, y] : {std::pair{big, 0}, {big - 1, 1}, {big, 2}, {big + 1, 1}}) rhombus.add_point(Point<int>(x, y));
+    EXPECT_EQ(rhombus.center().getX(), big);
+    EXPECT_EQ(rhombus.center<CompensatedArithmetic>().getY(), 1);
+}
+
+TEST(ArithmeticPolicyTest, ExactAreaForLargeCoordinates) {
+    // Единичный квадрат далеко от начала координат: члены формулы
+    // шнурования порядка 2^82, а удвоенная площадь равна 2
+    const long long b = (1LL << 41) + 1;
+    Trapezoid<long long> square(std::pmr::get_default_resource());
+    square.add_point(Point<long long>(b, b));
+    square.add_point(Point<long long>(b + 1, b));
+    square.add_point(Point<long long>(b + 1, b + 1));
+    square.add_point(Point<long long>(b, b + 1));
+    EXPECT_TRUE(square.twice_area_exact() == 2);
+    EXPECT_EQ(square.area<ExactArithmetic>(), 1.0);
+    EXPECT_EQ(square.area<CompensatedArithmetic>(), 1.0);
+
+    constexpr FixedRhombus<long long, ExactArithmetic> fixed(
+        Point<long long>(b, 0), Point<long long>(b + 1, 1), Point<long long>(b, 2), Point<long long>(b - 1, 1));
+    static_assert(fixed.area() == 2.0);
+    static_assert(fixed.center().getX() == b && fixed.center().getY() == 1);
+
+    // Обычные фигуры: все политики совпадают с кэшированной площадью
+    Pentagon<double> pentagon(std::pmr::get_default_resource());
+    for (auto [x, y] : {std::pair{0.0, 0.0}, {2.5, 0.0}, {3.0, 1.5}, {1.0, 3.0}, {-1.0, 1.0}}) pentagon.add_point(Point<double>(x, y));
+    EXPECT_EQ(pentagon.area<FastArithmetic>(), pentagon.area());
+    EXPECT_DOUBLE_EQ(pentagon.area<CompensatedArithmetic>(), pentagon.area());
+}
+
+// Тесты для счётчиков
+TEST(InstrumentTest, CountsHotPaths) {
+#if FIGURE_INSTRUMENT
+    instrument_reset();
+    Pentagon<int> pentagon(std::pmr::get_default_resource());
+    for (int i = 0; i < 6; ++i) pentagon.add_point(Point<int>(i, i * i));
+    pentagon.area();
+    pentagon.center();
+    Pentagon<int> copy(pentagon);
+
+    Array<int> values;
+    values.reserve(10);
+    for (int i = 0; i < 11; ++i) values.push_back(i);
+    std::thread worker([] {
+        Array<int> local;
+        local.reserve(4);
+    });
+    worker.join();
+
+    const auto snapshot = instrument_snapshot();
+    // Копия делит буфер с оригиналом и памяти не выделяет
+    EXPECT_EQ(snapshot[Counter::ContainerAlloc].count, 1);
+    EXPECT_EQ(snapshot[Counter::ContainerAlloc].bytes, 10 * sizeof(Point<int>));
+    EXPECT_EQ(snapshot[Counter::FigureCopy].count, 1);
+    EXPECT_EQ(snapshot[Counter::Area].count, 1);
+    EXPECT_EQ(snapshot[Counter::Center].count, 1);
+    EXPECT_EQ(snapshot[Counter::ArrayRealloc].count, 3);
+    EXPECT_EQ(snapshot[Counter::ArrayAlloc].count, 3);
+    EXPECT_EQ(snapshot[Counter::ArrayAlloc].bytes, (10 + 20 + 4) * sizeof(int));
+
+    std::ostringstream text, json;
+    dump_text(text, snapshot);
+    dump_json(json, snapshot);
+    EXPECT_NE(text.str().find("figure_copy: count=1 bytes=0"), std::string::npos);
+    EXPECT_EQ(json.str().rfind("{\"container_alloc\":{\"count\":1,", 0), 0);
+
+    // perf_event может быть недоступен (контейнеры, paranoid); тогда такты не считаются
+    if (!instrument_enable_cycles(true)) {
+        pentagon.area();
+        EXPECT_EQ(instrument_snapshot()[Counter::Area].cycles, 0);
+    }
+    instrument_enable_cycles(false);
+#else
+    GTEST_SKIP() << "built without FIGURE_INSTRUMENT";
+#endif
+}
+
+// Тесты для представлений фигур
+TEST(FigureViewTest, MatchesOwningFigures) {
+    const std::vector<Point<int>> buffer = {Point<int>(0, 0), Point<int>(2, 2), Point<int>(4, 0), Point<int>(2, -2)};
+    Rhombus<int> rhombus(std::pmr::get_default_resource());
+    for (const auto& p : buffer) rhombus.add_point(p);
+    const FigureView<int> view(FigureKind::Rhombus, PolygonSpan<int>(buffer));
+    EXPECT_EQ(view.area(), rhombus.area());
+    EXPECT_EQ(view.center().getX(), rhombus.center().getX());
+    EXPECT_EQ(view.center().getY(), rhombus.center().getY());
+    EXPECT_EQ(view.bounds().max_x, 4);
+    EXPECT_DOUBLE_EQ(view.vertices().centroid().getX(), rhombus.centroid().getX());
+
+    std::ostringstream from_view, from_figure;
+    from_view << view;
+    from_figure << rhombus;
+    EXPECT_EQ(from_view.str(), from_figure.str());
+
+    // Отдельные массивы координат
+    const double xs[] = {0, 2.5, 3, 1, -1}, ys[] = {0, 0, 1.5, 3, 1};
+    Pentagon<double> pentagon(std::pmr::get_default_resource());
+    for (int i = 0; i < 5; ++i) pentagon.add_point(Point<double>(xs[i], ys[i]));
+    const FigureView<double> split(FigureKind::Pentagon, PolygonSpan<double>(std::span<const double>(xs), std::span<const double>(ys)));
+    EXPECT_EQ(split.area(), pentagon.area());
+    EXPECT_EQ(split.center().getX(), pentagon.center().getX());
+    EXPECT_DOUBLE_EQ(static_cast<double>(split), pentagon.area<CompensatedArithmetic>());
+    std::ostringstream split_out, pentagon_out;
+    split_out << split;
+    pentagon_out << pentagon;
+    EXPECT_EQ(split_out.str(), pentagon_out.str());
+
+    const auto over_figure = FigureView<double>::of(pentagon);
+    EXPECT_EQ(over_figure.get_point(3).getX(), 1.0);
+    EXPECT_EQ(over_figure.vertices().size(), 5);
+
+    EXPECT_THROW(FigureView<int>(FigureKind::Pentagon, PolygonSpan<int>(buffer)), std::invalid_argument);
+    EXPECT_THROW(PolygonSpan<double>(std::span<const double>(xs), std::span<const double>(ys, 4)), std::invalid_argument);
+    EXPECT_THROW(view.get_point(4), std::out_of_range);
+}
+
+TEST(FigureViewTest, OverStoreWithoutAllocations) {
+    FigureStore<int> store;
+    store.push_back(FigureKind::Trapezoid, std::vector<Point<int>>{Point<int>(0, 0), Point<int>(4, 0), Point<int>(3, 2), Point<int>(1, 2)});
+    instrument_reset();
+    const FigureView<int> view = store[0];
+    EXPECT_EQ(view.kind(), FigureKind::Trapezoid);
+    EXPECT_DOUBLE_EQ(view.area(), 6.0);
+    EXPECT_EQ(view.center().getX(), store.center(0).getX());
+    const auto snapshot = instrument_snapshot();
+    EXPECT_EQ(snapshot[Counter::ContainerAlloc].count + snapshot[Counter::ArrayAlloc].count, 0);
+}
+
+// Тесты для массового создания фигур
+TEST(FactoryTest, MakeFigureWithoutOutput) {
+    testing::internal::CaptureStdout();
+    Rhombus<int> silent;
+    Pentagon<double> also_silent;
+    EXPECT_EQ(testing::internal::GetCapturedStdout(), "");
+
+    const auto rhombus = make_figure<Rhombus<int>>(std::vector<Point<int>>{Point<int>(0, 0), Point<int>(2, 2), Point<int>(4, 0), Point<int>(2, -2)});
+    EXPECT_DOUBLE_EQ(rhombus.area(), 8.0);
+    EXPECT_FALSE(rhombus.is_dirty());
+
+    const double xs[] = {0, 4, 3, 1}, ys[] = {0, 0, 2, 2};
+    const auto trapezoid = make_figure<Trapezoid<double>>(std::span<const double>(xs), std::span<const double>(ys));
+    EXPECT_DOUBLE_EQ(trapezoid.area(), 6.0);
+    EXPECT_THROW(make_figure<Pentagon<double>>(std::span<const double>(xs), std::span<const double>(ys)), std::invalid_argument);
+}
+
+TEST(FactoryTest, EmplaceFiguresAllocatesOnce) {
+    std::vector<int> xs, ys;
+    for (int i = 0; i < 1000; ++i) {
+        for (auto [x, y] : {std::pair{0, 0}, {1, 1}, {2, 0}, {1, -1}}) {
+            xs.push_back(x + i);
+            ys.push_back(y);
+        }
+    }
+    instrument_reset();
+    Array<Rhombus<int>> figures;
+    emplace_figures<Rhombus<int>>(figures, std::span<const int>(xs), std::span<const int>(ys));
+    const auto snapshot = instrument_snapshot();
+    ASSERT_EQ(figures.size(), 1000);
+    EXPECT_DOUBLE_EQ(figures[999].area(), 2.0);
+    EXPECT_EQ(figures[999].center().getX(), 1000);
+#if FIGURE_INSTRUMENT
+    EXPECT_EQ(snapshot[Counter::ArrayAlloc].count, 1);
+    EXPECT_EQ(snapshot[Counter::ContainerAlloc].count, 0);
+#else
+    (void)snapshot;
+#endif
+
+    Arena arena;
+    Array<shared_ptr<Figure<int>>> pointers;
+    emplace_figures<Rhombus<int>>(pointers, std::span<const int>(xs), std::span<const int>(ys), arena);
+    ASSERT_EQ(pointers.size(), 1000);
+    EXPECT_DOUBLE_EQ(static_cast<double>(*pointers[10]), 2.0);
+    EXPECT_GT(arena.bytes_used(), 1000 * sizeof(Rhombus<int>));
+
+    std::vector<int> odd(xs.begin(), xs.begin() + 6);
+    EXPECT_THROW(emplace_figures<Rhombus<int>>(figures, std::span<const int>(odd), std::span<const int>(odd)), std::invalid_argument);
+}
+
+// Тесты для отсечения
+template<class F>
+static F figure_of(std::initializer_list<std::pair<int, int>> points) {
+    F figure(std::pmr::get_default_resource());
+    for (auto [x, y] : points) figure.add_point(Point<int>(x, y));
+    return figure;
+}
+
+TEST(ClippingTest, ConvexShapes) {
+    const auto square = figure_of<Trapezoid<int>>({{0, 0}, {4, 0}, {4, 4}, {0, 4}});
+    const auto rhombus = figure_of<Rhombus<int>>({{2, 2}, {4, 0}, {6, 2}, {4, 4}});
+    Clipper clipper;
+    ClipResult result;
+    clipper.clip(ClipOp::Intersection, square, rhombus, result);
+    clipper.clip(ClipOp::Union, square, rhombus, result);
+    clipper.clip(ClipOp::Difference, square, rhombus, result);
+    ASSERT_EQ(result.group_count(), 3);
+    EXPECT_DOUBLE_EQ(result.group_area(0), 4.0);
+    EXPECT_DOUBLE_EQ(result.group_area(1), 20.0);
+    EXPECT_DOUBLE_EQ(result.group_area(2), 12.0);
+    EXPECT_EQ(result[0].size(), 3);
+    EXPECT_DOUBLE_EQ(clipper.area(ClipOp::Intersection, rhombus, square), 4.0);
+
+    const auto polygon = make_polygon(result[0]);
+    EXPECT_DOUBLE_EQ(polygon.area(), 4.0);
+    EXPECT_NEAR(polygon.center().getX(), 10.0 / 3, 1e-12);
+
+    ClipResult convex;
+    clipper.clip_convex(PolygonSpan<int>(square.vertices()), PolygonSpan<int>(rhombus.vertices()), convex);
+    EXPECT_DOUBLE_EQ(convex.area(), 4.0);
+}
+
+TEST(ClippingTest, SharedEdgesAndHoles) {
+    const auto left = figure_of<Trapezoid<int>>({{0, 0}, {2, 0}, {2, 2}, {0, 2}});
+    const auto right = figure_of<Trapezoid<int>>({{2, 0}, {4, 0}, {4, 2}, {2, 2}});
+    Clipper clipper;
+    ClipResult merged;
+    clipper.clip(ClipOp::Union, left, right, merged);
+    ASSERT_EQ(merged.size(), 1);
+    EXPECT_EQ(merged[0].size(), 4);
+    EXPECT_DOUBLE_EQ(merged.area(), 8.0);
+    EXPECT_DOUBLE_EQ(clipper.area(ClipOp::Intersection, left, right), 0.0);
+    EXPECT_DOUBLE_EQ(clipper.area(ClipOp::Difference, left, right), 4.0);
+
+    EXPECT_DOUBLE_EQ(clipper.area(ClipOp::Intersection, left, left), 4.0);
+    EXPECT_DOUBLE_EQ(clipper.area(ClipOp::Union, left, left), 4.0);
+    EXPECT_DOUBLE_EQ(clipper.area(ClipOp::Difference, left, left), 0.0);
+
+    const auto big = figure_of<Trapezoid<int>>({{0, 0}, {10, 0}, {10, 10}, {0, 10}});
+    const auto small = figure_of<Rhombus<int>>({{3, 2}, {4, 3}, {3, 4}, {2, 3}});
+    ClipResult holed;
+    clipper.clip(ClipOp::Difference, big, small, holed);
+    ASSERT_EQ(holed.size(), 2);
+    EXPECT_DOUBLE_EQ(holed.area(), 98.0);
+    EXPECT_LT(std::min(holed.signed_area(0), holed.signed_area(1)), 0.0);
+    EXPECT_DOUBLE_EQ(clipper.area(ClipOp::Union, small, big), 100.0);
+    EXPECT_DOUBLE_EQ(clipper.area(ClipOp::Difference, small, big), 0.0);
+}
+
+TEST(ClippingTest, NonConvexAndBatch) {
+    // "Стрелка" с вырезом сверху, площадь 24
+    const auto arrow = figure_of<Pentagon<int>>({{0, 0}, {6, 0}, {6, 6}, {3, 2}, {0, 6}});
+    const auto strip = figure_of<Trapezoid<int>>({{0, 0}, {6, 0}, {6, 4}, {0, 4}});
+    Clipper clipper;
+    EXPECT_DOUBLE_EQ(clipper.area(ClipOp::Intersection, arrow, strip), 21.0);
+    EXPECT_DOUBLE_EQ(clipper.area(ClipOp::Union, arrow, strip), 27.0);
+    EXPECT_DOUBLE_EQ(clipper.area(ClipOp::Difference, arrow, strip), 3.0);
+    ClipResult tips;
+    clipper.clip(ClipOp::Difference, arrow, strip, tips);
+    EXPECT_EQ(tips.size(), 2);
+    EXPECT_THROW(clipper.clip_convex(PolygonSpan<int>(strip.vertices()), PolygonSpan<int>(arrow.vertices()), tips), std::invalid_argument);
+
+    // Пакет: площади согласованы между операциями
+    const auto figures = random_scene(200, 17);
+    std::vector<std::pair<size_t, size_t>> pairs;
+    for (size_t i = 0; i < figures.size(); ++i) {
+        for (size_t j = i + 1; j < figures.size(); ++j) {
+            if (figures[i]->bounds().intersects(figures[j]->bounds())) pairs.emplace_back(i, j);
+        }
+    }
+    ASSERT_FALSE(pairs.empty());
+    ClipResult inter, uni, diff;
+    clipper.clip_pairs(ClipOp::Intersection, figures, std::span<const std::pair<size_t, size_t>>(pairs), inter);
+    clipper.clip_pairs(ClipOp::Union, figures, std::span<const std::pair<size_t, size_t>>(pairs), uni);
+    clipper.clip_pairs(ClipOp::Difference, figures, std::span<const std::pair<size_t, size_t>>(pairs), diff);
+    ASSERT_EQ(inter.group_count(), pairs.size());
+    for (size_t k = 0; k < pairs.size(); ++k) {
+        const double a = figures[pairs[k].first]->area(), b = figures[pairs[k].second]->area();
+        const double i = inter.group_area(k);
+        EXPECT_GE(i, -1e-9);
+        EXPECT_NEAR(uni.group_area(k), a + b - i, 1e-7);
+        EXPECT_NEAR(diff.group_area(k), a - i, 1e-7);
+    }
+}
+
+// Тесты для оболочки и упрощения
+TEST(SimplifyTest, ConvexHull) {
+    std::vector<Point<int>> points;
+    for (int x = 0; x <= 10; ++x) {
+        for (int y = 0; y <= 10; ++y) points.emplace_back(x, y);
+    }
+    const auto hull = convex_hull(std::span<const Point<int>>(points));
+    EXPECT_EQ(hull.get_points_count(), 4);
+    EXPECT_DOUBLE_EQ(hull.area(), 100.0);
+    EXPECT_GT(hull.signed_area(), 0.0);
+
+    std::mt19937 rng(8);
+    std::normal_distribution<double> coord(0, 1000);
+    std::vector<Point<long long>> cloud;
+    for (int i = 0; i < 100000; ++i) cloud.emplace_back(std::llround(coord(rng)), std::llround(coord(rng)));
+    const auto parallel = convex_hull(std::span<const Point<long long>>(cloud), 4);
+    const auto sequential = convex_hull(std::span<const Point<long long>>(cloud), 1);
+    ASSERT_EQ(parallel.get_points_count(), sequential.get_points_count());
+    for (size_t i = 0; i < parallel.get_points_count(); ++i) {
+        EXPECT_EQ(parallel.get_point(i).getX(), sequential.get_point(i).getX());
+        EXPECT_EQ(parallel.get_point(i).getY(), sequential.get_point(i).getY());
+    }
+    std::vector<uint8_t> inside(cloud.size());
+    PolygonEdges<long long>(parallel).contains(cloud, inside);
+    EXPECT_EQ(std::count(inside.begin(), inside.end(), 1), static_cast<long>(cloud.size()));
+}
+
+TEST(SimplifyTest, RdpAndVisvalingam) {
+    // Квадрат с лишними точками на сторонах
+    std::vector<Point<int>> square;
+    for (int i = 0; i < 10; ++i) square.emplace_back(i, 0);
+    for (int i = 0; i < 10; ++i) square.emplace_back(10, i);
+    for (int i = 10; i > 0; --i) square.emplace_back(i, 10);
+    for (int i = 10; i > 0; --i) square.emplace_back(0, i);
+    const std::span<const Point<int>> span(square);
+    const auto rdp = simplify_rdp(span, 0.5);
+    const auto vw = simplify_visvalingam(span, 0.5);
+    EXPECT_EQ(rdp.get_points_count(), 4);
+    EXPECT_EQ(vw.get_points_count(), 4);
+    EXPECT_DOUBLE_EQ(rdp.area(), 100.0);
+    EXPECT_DOUBLE_EQ(vw.area(), 100.0);
+
+    // Окружность из 20000 точек
+    std::vector<Point<double>> circle;
+    const double pi = std::acos(-1.0);
+    for (int i = 0; i < 20000; ++i) circle.emplace_back(1000 * std::cos(2 * pi * i / 20000), 1000 * std::sin(2 * pi * i / 20000));
+    Polygon<double> original;
+    original.add_points(circle);
+    const auto coarse = simplify_rdp(original, 1.0);
+    const auto coarse_vw = simplify_visvalingam(original, 50.0);
+    EXPECT_LT(coarse.get_points_count(), 200);
+    EXPECT_GT(coarse.get_points_count(), 20);
+    EXPECT_LT(coarse_vw.get_points_count(), 200);
+    EXPECT_NEAR(coarse.area(), original.area(), original.area() * 0.01);
+    EXPECT_NEAR(coarse_vw.area(), original.area(), original.area() * 0.01);
+    EXPECT_EQ(simplify_rdp(original, 1e9).get_points_count(), 3);
+    EXPECT_EQ(simplify_visvalingam(original, 1e12).get_points_count(), 3);
+}
+
+// Тесты для общих буферов точек (copy-on-write)
+TEST(CopyOnWriteTest, CopySharesUntilMutation) {
+    Polygon<int> original;
+    for (int i = 0; i < 8; ++i) original.add_point(Point<int>(i, i * i));
+    Polygon<int> copy(original);
+    EXPECT_EQ(copy.vertices().data(), original.vertices().data());
+    EXPECT_DOUBLE_EQ(copy.area(), original.area());
+
+    // Изменение копии отделяет её буфер, оригинал не меняется
+    copy.add_point(Point<int>(100, 0));
+    EXPECT_NE(copy.vertices().data(), original.vertices().data());
+    EXPECT_EQ(original.get_points_count(), 8);
+    EXPECT_EQ(copy.get_points_count(), 9);
+    EXPECT_EQ(copy.get_point(7).getY(), 49);
+
+    // Присваивание тоже делит буфер; встроенные точки копируются
+    Polygon<int> assigned;
+    assigned.add_point(Point<int>(1, 1));
+    static_cast<Figure<int>&>(assigned) = original;
+    EXPECT_EQ(assigned.vertices().data(), original.vertices().data());
+    Rhombus<int> small;
+    for (const auto& p : {Point<int>(0, 0), Point<int>(1, 1), Point<int>(2, 0), Point<int>(1, -1)}) small.add_point(p);
+    Rhombus<int> small_copy(small);
+    EXPECT_NE(small_copy.vertices().data(), small.vertices().data());
+    EXPECT_EQ(small_copy.area(), small.area());
+}
+
+TEST(CopyOnWriteTest, MutableReferenceStopsSharing) {
+    // Ссылка, взятая до копирования, не должна менять копию
+    PointContainer<Point<int>> a;
+    for (int i = 0; i < 8; ++i) a.push_back(Point<int>(i, i));
+    Point<int>& r = a[0];
+    PointContainer<Point<int>> b(a);
+    r = Point<int>(100, 100);
+    EXPECT_EQ(b[0].getX(), 0);
+    EXPECT_EQ(a[0].getX(), 100);
+    EXPECT_FALSE(a.is_shared());
+
+    // Так же для указателя из data() и итератора из begin()
+    Point<int>* raw = a.data();
+    PointContainer<Point<int>> c(a);
+    raw[1] = Point<int>(-1, -1);
+    EXPECT_EQ(std::as_const(c)[1].getX(), 1);
+    auto it = a.begin();
+    PointContainer<Point<int>> d(a);
+    *it = Point<int>(7, 7);
+    EXPECT_EQ(std::as_const(d)[0].getX(), 100);
+
+    // Без изменяемого доступа копия по-прежнему делит буфер
+    PointContainer<Point<int>> e(std::as_const(d));
+    EXPECT_EQ(std::as_const(e).data(), std::as_const(d).data());
+}
+
+TEST(CopyOnWriteTest, ArenaCopyDoesNotShare) {
+    std::optional<Polygon<int>> copy;
+    {
+        Arena arena;
+        Polygon<int> original(&arena);
+        for (int i = 0; i < 8; ++i) original.add_point(Point<int>(i, -i));
+        copy.emplace(original);
+        // Точки из арены копируются в ресурс по умолчанию
+        EXPECT_NE(copy->vertices().data(), original.vertices().data());
+        Polygon<int> assigned;
+        static_cast<Figure<int>&>(assigned) = original;
+        EXPECT_NE(assigned.vertices().data(), original.vertices().data());
+    }
+    // Арена уже разрушена
+    EXPECT_EQ(copy->get_point(7).getX(), 7);
+    copy->add_point(Point<int>(100, 100));
+    EXPECT_EQ(copy->get_points_count(), 9);
+}
+
+TEST(CopyOnWriteTest, ArrayCopyAndThreads) {
+    Array<Polygon<int>> scene;
+    for (int f = 0; f < 100; ++f) {
+        Polygon<int>& polygon = scene.emplace_back();
+        for (int i = 0; i < 16; ++i) polygon.add_point(Point<int>(f + i, i % 3));
+    }
+    Array<Polygon<int>> copy(scene);
+    for (size_t f = 0; f < scene.size(); ++f) EXPECT_EQ(copy[f].vertices().data(), scene[f].vertices().data());
+
+    // Копии создаются, меняются и разрушаются в разных потоках одновременно
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; ++t) {
+        workers.emplace_back([&scene, t] {
+            for (int round = 0; round < 50; ++round) {
+                Array<Polygon<int>> local(scene);
+                local[round % local.size()].add_point(Point<int>(t, round));
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+    copy = Array<Polygon<int>>();
+    for (const auto& polygon : scene) EXPECT_EQ(polygon.get_points_count(), 16);
+}
+
+// Тесты для сцены со снимками
+TEST(SceneTest, SnapshotsAndSegments) {
+    EXPECT_EQ(Scene<int>::segment_of(0), 0);
+    EXPECT_EQ(Scene<int>::segment_of(63), 0);
+    EXPECT_EQ(Scene<int>::segment_of(64), 1);
+    EXPECT_EQ(Scene<int>::segment_of(191), 1);
+    EXPECT_EQ(Scene<int>::segment_of(192), 2);
+    EXPECT_EQ(Scene<int>::segment_start(2), 192);
+
+    const auto figures = random_scene(10000, 5);
+    Scene<int> scene;
+    scene.push_back(figures[0]);
+    const auto first = scene.snapshot();
+    scene.append(figures);
+    EXPECT_EQ(first.size(), 1);
+    EXPECT_EQ(first[0].get(), figures[0].get());
+    EXPECT_THROW(first[1], std::out_of_range);
+    EXPECT_THROW(scene.push_back(nullptr), std::invalid_argument);
+
+    const auto all = scene.snapshot();
+    EXPECT_EQ(all.size(), 10001);
+    EXPECT_EQ(all[10000].get(), figures[9999].get());
+    size_t visited = 0;
+    all.visit_segments([&](std::span<const Scene<int>::value_type> part) { visited += part.size(); });
+    EXPECT_EQ(visited, all.size());
+    EXPECT_EQ(static_cast<size_t>(std::distance(all.begin(), all.end())), all.size());
+
+    const double expected = parallel_total_area(figures, 1) + figures[0]->area();
+    EXPECT_NEAR(all.total_area(), expected, 1e-6);
+    ThreadPool pool(4);
+    EXPECT_DOUBLE_EQ(parallel_total_area(all, pool), all.total_area());
+
+    scene.emplace_back<Rhombus<int>>();
+    EXPECT_EQ(scene.size(), 10002);
+    EXPECT_EQ(all.size(), 10001);
+}
+
+TEST(SceneTest, ReadersDoNotBlockWriter) {
+    const auto figures = random_scene(20000, 9);
+    Scene<int> scene;
+    std::atomic<bool> done{false};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 8; ++t) {
+        readers.emplace_back([&] {
+            size_t last = 0;
+            while (!done.load(std::memory_order_acquire)) {
+                const auto snapshot = scene.snapshot();
+                EXPECT_GE(snapshot.size(), last);
+                last = snapshot.size();
+                double area = 0;
+                for (const auto& figure : snapshot) area += figure->area();
+                EXPECT_GE(area, 0.0);
+            }
+        });
+    }
+    for (size_t i = 0; i < figures.size(); ++i) scene.push_back(figures[i]);
+    done.store(true, std::memory_order_release);
+    for (auto& reader : readers) reader.join();
+    EXPECT_NEAR(scene.snapshot().total_area(), parallel_total_area(figures, 1), 1e-6);
+}
+
+// Тесты для сжатого хранилища
+TEST(CompressedStoreTest, LosslessIntegers) {
+    FigureStore<int> store;
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<int> pos(-100000, 100000), step(-50, 50);
+    for (int f = 0; f < 3000; ++f) {
+        const FigureKind kind = static_cast<FigureKind>(f % 3);
+        std::vector<Point<int>> points;
+        int x = pos(rng), y = pos(rng);
+        for (size_t j = 0; j < figure_arity(kind); ++j) {
+            points.emplace_back(x, y);
+            x += step(rng);
+            y += step(rng);
+        }
+        store.push_back(kind, points);
+    }
+    // Крайние значения тоже восстанавливаются точно
+    store.push_back(FigureKind::Rhombus, std::vector<Point<int>>{Point<int>(INT32_MIN, INT32_MAX), Point<int>(INT32_MAX, INT32_MIN),
+                                                                  Point<int>(0, 0), Point<int>(-1, 1)});
+
+    const auto reference = areas(store, SimdLevel::Scalar);
+    for (VertexEncoding encoding : {VertexEncoding::Varint, VertexEncoding::FixedWidth}) {
+        const auto compressed = CompressedFigureStore<int>::from(store, encoding);
+        ASSERT_EQ(compressed.size(), store.size());
+        EXPECT_LT(compressed.byte_size(), store.vertex_count() * 2 * sizeof(int) + store.offsets().size_bytes() + store.size());
+        const auto decoded = compressed.decode_all();
+        EXPECT_TRUE(std::equal(decoded.xs().begin(), decoded.xs().end(), store.xs().begin()));
+        EXPECT_TRUE(std::equal(decoded.ys().begin(), decoded.ys().end(), store.ys().begin()));
+
+        std::vector<double> values(compressed.size());
+        compressed.areas(values);
+        EXPECT_EQ(values, reference);
+        EXPECT_EQ(compressed.area(5), store.area(5));
+        EXPECT_EQ(compressed.center(7).getX(), store.center(7).getX());
+        EXPECT_EQ(compressed.center(7).getY(), store.center(7).getY());
+        EXPECT_EQ(compressed.kind(2), FigureKind::Pentagon);
+        EXPECT_THROW(compressed.kind(compressed.size()), std::out_of_range);
+    }
+}
+
+TEST(CompressedStoreTest, QuantizedDoubles) {
+    EXPECT_THROW(CompressedFigureStore<double>(), std::invalid_argument);
+    EXPECT_THROW(CompressedFigureStore<int>(VertexEncoding::Varint, -1), std::invalid_argument);
+
+    CompressedFigureStore<double> compressed(VertexEncoding::FixedWidth, 0.001);
+    Rhombus<double> rhombus;
+    for (const auto& p : {Point<double>(0.0004, 0), Point<double>(2.0001, 2), Point<double>(4, 0), Point<double>(2, -2)}) {
+        rhombus.add_point(p);
+    }
+    compressed.push_back(rhombus);
+    EXPECT_THROW(compressed.push_back(FigureKind::Rhombus, std::vector<Point<double>>(3)), std::invalid_argument);
+    EXPECT_THROW(compressed.push_back(FigureKind::Rhombus, std::vector<Point<double>>(4, Point<double>(1e300, 0))),
+                 std::out_of_range);
+
+    std::array<Point<double>, 5> points;
+    ASSERT_EQ(compressed.decode(0, points), 4);
+    EXPECT_EQ(points[0].getX(), 0.0);
+    EXPECT_DOUBLE_EQ(points[1].getX(), 2.0);
+    EXPECT_NEAR(compressed.area(0), rhombus.area(), 0.01);
+    EXPECT_NEAR(compressed.total_area(), 8.0, 0.01);
+    // Точка, 6 разностей шириной 13 бит и смещения
+    EXPECT_LE(compressed.byte_size(), 24);
+
+    // Плотно лежащие фигуры с шагом сетки 0.01 занимают в разы меньше
+    FigureStore<double> store;
+    CompressedFigureStore<double> dense(VertexEncoding::FixedWidth, 0.01);
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<double> pos(0, 100), size(0.1, 2);
+    for (int f = 0; f < 1000; ++f) {
+        const double x = pos(rng), y = pos(rng), w = size(rng), h = size(rng);
+        const std::vector<Point<double>> rhomb = {Point<double>(x - w, y), Point<double>(x, y + h), Point<double>(x + w, y),
+                                                  Point<double>(x, y - h)};
+        store.push_back(FigureKind::Rhombus, rhomb);
+        dense.push_back(FigureKind::Rhombus, rhomb);
+    }
+    EXPECT_LT(dense.byte_size() * 3, store.vertex_count() * 2 * sizeof(double) + store.offsets().size_bytes() + store.size());
+    EXPECT_NEAR(dense.total_area(), simd_total_area(store), 0.01 * 1000);
+}
+
+// Тесты для конвейера пакетной обработки
+TEST(PipelineTest, BoundedQueueManyThreads) {
+    BoundedQueue<int> queue(8);
+    EXPECT_EQ(queue.capacity(), 8);
+    std::atomic<long long> sum{0};
+    std::atomic<int> producing{4};
+    std::vector<std::thread> threads;
+    for (int p = 0; p < 4; ++p) {
+        threads.emplace_back([&, p] {
+            for (int i = 1; i <= 10000; ++i) queue.push(p * 10000 + i);
+            if (producing.fetch_sub(1) == 1) queue.close();
+        });
+    }
+    for (int c = 0; c < 4; ++c) {
+        threads.emplace_back([&] {
+            int value;
+            while (queue.pop(value)) sum += value;
+        });
+    }
+    for (auto& t : threads) t.join();
+    EXPECT_EQ(sum.load(), 40000LL * 40001 / 2);
+}
+
+TEST(PipelineTest, BoundedQueueWakesSleepers) {
+    // Ждущие успевают уснуть в wait; их будят push, pop и close
+    BoundedQueue<int> queue(2);
+    int value = 0;
+    std::thread consumer([&] { EXPECT_TRUE(queue.pop(value)); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    queue.push(7);
+    consumer.join();
+    EXPECT_EQ(value, 7);
+
+    queue.push(1);
+    queue.push(2);
+    std::thread producer([&] { queue.push(3); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_TRUE(queue.pop(value));
+    producer.join();
+    EXPECT_TRUE(queue.pop(value));
+    EXPECT_TRUE(queue.pop(value));
+    EXPECT_EQ(value, 3);
+
+    std::thread waiter([&] { EXPECT_FALSE(queue.pop(value)); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    queue.close();
+    waiter.join();
+}
+
+TEST(PipelineTest, MatchesSequentialInOrder) {
+    std::string text = "# сцена\n";
+    std::mt19937 rng(21);
+    std::uniform_int_distribution<int> pos(-50, 50);
+    for (int f = 0; f < 2000; ++f) {
+        const char tag = "RTP"[f % 3];
+        text += tag;
+        for (int j = 0; j < (tag == 'P' ? 10 : 8); ++j) {
+            text += ' ';
+            text += std::to_string(pos(rng));
+        }
+        text += f % 7 == 0 ? "\n\n" : "\n";
+    }
+    text.pop_back(); // последняя строка без перевода строки
+    FigureStore<double> store;
+    parse_figures(text, store);
+
+    std::istringstream in(text);
+    std::ostringstream out;
+    PipelineOptions options;
+    options.workers = 4;
+    options.batch_bytes = 256;
+    options.queue_capacity = 2;
+    const auto stats = run_pipeline<double>(in, out, options);
+    EXPECT_EQ(stats.figures, store.size());
+    EXPECT_NEAR(stats.total_area, store.total_area(), 1e-6);
+
+    std::istringstream lines(out.str());
+    std::string line;
+    for (size_t i = 0; i < store.size(); ++i) {
+        ASSERT_TRUE(std::getline(lines, line));
+        std::istringstream fields(line);
+        size_t index;
+        char tag;
+        double area, x, y;
+        fields >> index >> tag >> area >> x >> y;
+        EXPECT_EQ(index, i);
+        EXPECT_EQ(tag, "RTP"[i % 3]);
+        EXPECT_EQ(area, store.area(i));
+        EXPECT_EQ(x, store.center(i).getX());
+        EXPECT_EQ(y, store.center(i).getY());
+    }
+    ASSERT_TRUE(std::getline(lines, line));
+    EXPECT_EQ(line, "figures: 2000");
+}
+
+TEST(PipelineTest, ReportsErrorLine) {
+    std::string text;
+    for (int i = 0; i < 500; ++i) text += "R 0 0 2 2 4 0 2 -2\n";
+    text += "R 0 0 2 x 4 0 2 -2\n";
+    for (int i = 0; i < 500; ++i) text += "R 0 0 2 2 4 0 2 -2\n";
+    // Всё до ошибочной строки выведено, даже если она в одной пачке с ними
+    for (size_t batch_bytes : {size_t(1), size_t(100), size_t(1000), size_t(1) << 20}) {
+        std::istringstream in(text);
+        std::ostringstream out;
+        PipelineOptions options;
+        options.workers = 3;
+        options.batch_bytes = batch_bytes;
+        try {
+            run_pipeline<int>(in, out, options);
+            ADD_FAILURE() << "expected ParseError, batch_bytes = " << batch_bytes;
+        } catch (const ParseError& e) {
+            EXPECT_EQ(e.line(), 501);
+            EXPECT_EQ(e.column(), 9);
+        }
+        const std::string written = out.str();
+        EXPECT_EQ(std::count(written.begin(), written.end(), '\n'), 500) << "batch_bytes = " << batch_bytes;
+        EXPECT_EQ(written.rfind("499 R 8 2 0\n"), written.size() - 12) << "batch_bytes = " << batch_bytes;
+    }
+}
+
+// Тесты для массового вывода
+TEST(SerializerTest, TextMatchesStreamOperators) {
+    const std::vector<double> values = {0, -0.0, 1.0 / 3, 1e-7, 123456789.0, -2.5, 1e21, 0.1 + 0.2, 99999.95, 1e300};
+    Array<shared_ptr<Figure<double>>> scene;
+    std::ostringstream expected;
+    for (size_t f = 0; f < 300; ++f) {
+        shared_ptr<Figure<double>> figure;
+        if (f % 4 == 0) figure = make_shared<Rhombus<double>>();
+        else if (f % 4 == 1) figure = make_shared<Trapezoid<double>>();
+        else if (f % 4 == 2) figure = make_shared<Pentagon<double>>();
+        else figure = make_shared<Polygon<double>>();
+        const size_t n = f % 4 == 2 ? 5 : f % 4 == 3 ? 7 : 4;
+        for (size_t i = 0; i < n; ++i) figure->add_point(Point<double>(values[(f + i) % values.size()], values[(f * 3 + i) % values.size()] * f));
+        scene.push_back(figure);
+        expected << *figure;
+    }
+    std::ostringstream text;
+    serialize_figures(text, scene);
+    EXPECT_EQ(text.str(), expected.str());
+
+    // Статический тип фигуры, представления и хранилище; маленький блок
+    // заставляет сбрасывать буфер много раз
+    Rhombus<int> rhombus;
+    for (const auto& p : {Point<int>(0, 0), Point<int>(-2, 2), Point<int>(4, 0), Point<int>(2, -2147483647)}) rhombus.add_point(p);
+    FigureStore<int> store;
+    store.push_back(rhombus);
+    store.push_back(FigureKind::Pentagon, std::vector<Point<int>>{Point<int>(0, 0), Point<int>(2, 0), Point<int>(3, 1),
+                                                                   Point<int>(2, 2), Point<int>(0, 2)});
+    std::ostringstream streamed, written;
+    streamed << rhombus << FigureView<int>(store[0]) << FigureView<int>(store[1]);
+    {
+        FigureWriter<int> writer(written, OutputFormat::Text, 16);
+        writer.write(rhombus);
+        writer.write_all(store);
+        EXPECT_EQ(writer.count(), 3);
+    }
+    EXPECT_EQ(written.str(), streamed.str());
+
+    // Точность берётся из потока
+    std::ostringstream precise, precise_expected;
+    precise.precision(12);
+    precise_expected.precision(12);
+    precise_expected << *scene[2];
+    FigureWriter<double>(precise).write(*scene[2]);
+    EXPECT_EQ(precise.str(), precise_expected.str());
+}
+
+TEST(SerializerTest, CsvAndJsonLines) {
+    Rhombus<double> rhombus;
+    for (const auto& p : {Point<double>(0.1, 0), Point<double>(2, 2), Point<double>(4, 0), Point<double>(2, -2)}) rhombus.add_point(p);
+    Polygon<double> polygon;
+    for (const auto& p : {Point<double>(0, 0), Point<double>(1, 0), Point<double>(0, std::numeric_limits<double>::infinity())}) {
+        polygon.add_point(p);
+    }
+    Array<shared_ptr<Figure<double>>> scene;
+    scene.push_back(make_shared<Rhombus<double>>(rhombus));
+    scene.push_back(make_shared<Polygon<double>>(polygon));
+
+    std::ostringstream csv, json;
+    serialize_figures(csv, scene, OutputFormat::Csv);
+    serialize_figures(json, scene, OutputFormat::JsonLines);
+    EXPECT_EQ(csv.str(),
+              "figure,kind,point,x,y\n"
+              "0,rhombus,0,0.1,0\n0,rhombus,1,2,2\n0,rhombus,2,4,0\n0,rhombus,3,2,-2\n"
+              "1,polygon,0,0,0\n1,polygon,1,1,0\n1,polygon,2,0,inf\n");
+    EXPECT_EQ(json.str(),
+              "{\"kind\":\"rhombus\",\"points\":[[0.1,0],[2,2],[4,0],[2,-2]]}\n"
+              "{\"kind\":\"polygon\",\"points\":[[0,0],[1,0],[0,null]]}\n");
+}
+
 // Тесты для концептов
 TEST(ConceptTest, PointableConcept) {
     EXPECT_TRUE(Pointable<int>);